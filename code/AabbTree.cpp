@@ -0,0 +1,371 @@
+#include "AabbTree.h"
+
+#include <algorithm>
+
+static Bounds Union(const Bounds& a, const Bounds& b)
+{
+	Bounds bounds = a;
+	bounds.Expand(b);
+	return bounds;
+}
+
+AabbTree::AabbTree() : root(-1), freeList(-1)
+{
+}
+
+void AabbTree::Clear()
+{
+	nodes.clear();
+	root = -1;
+	freeList = -1;
+}
+
+int AabbTree::AllocateNode()
+{
+	if (freeList == -1) {
+		AabbTreeNode node;
+		node.height = -1;
+		node.parent = -1;
+		nodes.push_back(node);
+		freeList = (int)nodes.size() - 1;
+	}
+	const int node = freeList;
+	freeList = nodes[node].parent;
+	nodes[node].parent = -1;
+	nodes[node].child1 = -1;
+	nodes[node].child2 = -1;
+	nodes[node].height = 0;
+	nodes[node].bodyId = -1;
+	return node;
+}
+
+void AabbTree::FreeNode(const int node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+int AabbTree::CreateProxy(const Bounds& fatBounds, const int bodyId)
+{
+	const int proxy = AllocateNode();
+	nodes[proxy].bounds = fatBounds;
+	nodes[proxy].bodyId = bodyId;
+	InsertLeaf(proxy);
+	return proxy;
+}
+
+void AabbTree::DestroyProxy(const int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+}
+
+void AabbTree::MoveProxy(const int proxy, const Bounds& fatBounds)
+{
+	RemoveLeaf(proxy);
+	nodes[proxy].bounds = fatBounds;
+	InsertLeaf(proxy);
+}
+
+void AabbTree::ReplaceChild(const int parent, const int oldChild, const int newChild)
+{
+	if (parent == -1) {
+		root = newChild;
+	}
+	else if (nodes[parent].child1 == oldChild) {
+		nodes[parent].child1 = newChild;
+	}
+	else {
+		nodes[parent].child2 = newChild;
+	}
+}
+
+void AabbTree::InsertLeaf(const int leaf)
+{
+	if (root == -1) {
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+
+	// Walk down to the sibling with the cheapest surface area increase
+	const Bounds leafBounds = nodes[leaf].bounds;
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		const AabbTreeNode& node = nodes[index];
+		const float area = node.bounds.SurfaceArea();
+		const float combinedArea = Union(node.bounds, leafBounds).SurfaceArea();
+
+		// Cost of making a new parent for this node and the leaf
+		const float cost = 2.0f * combinedArea;
+		// Minimum cost of pushing the leaf further down
+		const float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		const int children[2] = { node.child1, node.child2 };
+		for (int i = 0; i < 2; i++) {
+			const AabbTreeNode& child = nodes[children[i]];
+			const float childArea = Union(child.bounds, leafBounds).SurfaceArea();
+			childCost[i] = child.IsLeaf() ? childArea : childArea - child.bounds.SurfaceArea();
+			childCost[i] += inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1]) {
+			break;
+		}
+		index = (childCost[0] < childCost[1]) ? children[0] : children[1];
+	}
+	const int sibling = index;
+
+	const int oldParent = nodes[sibling].parent;
+	const int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].bounds = Union(leafBounds, nodes[sibling].bounds);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	ReplaceChild(oldParent, sibling, newParent);
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	// Refit and rebalance the ancestors
+	index = nodes[leaf].parent;
+	while (index != -1) {
+		index = Balance(index);
+		AabbTreeNode& node = nodes[index];
+		node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+		node.bounds = Union(nodes[node.child1].bounds, nodes[node.child2].bounds);
+		index = node.parent;
+	}
+}
+
+void AabbTree::RemoveLeaf(const int leaf)
+{
+	if (leaf == root) {
+		root = -1;
+		return;
+	}
+
+	const int parent = nodes[leaf].parent;
+	const int grandParent = nodes[parent].parent;
+	const int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	// The sibling takes the place of the parent
+	ReplaceChild(grandParent, parent, sibling);
+	nodes[sibling].parent = grandParent;
+	FreeNode(parent);
+
+	int index = grandParent;
+	while (index != -1) {
+		index = Balance(index);
+		AabbTreeNode& node = nodes[index];
+		node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+		node.bounds = Union(nodes[node.child1].bounds, nodes[node.child2].bounds);
+		index = node.parent;
+	}
+}
+
+int AabbTree::Balance(const int iA)
+{
+	AabbTreeNode& A = nodes[iA];
+	if (A.IsLeaf() || A.height < 2) {
+		return iA;
+	}
+
+	const int iB = A.child1;
+	const int iC = A.child2;
+	AabbTreeNode& B = nodes[iB];
+	AabbTreeNode& C = nodes[iC];
+	const int balance = C.height - B.height;
+
+	// Rotate C up
+	if (balance > 1) {
+		const int iF = C.child1;
+		const int iG = C.child2;
+		AabbTreeNode& F = nodes[iF];
+		AabbTreeNode& G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+		ReplaceChild(C.parent, iA, iC);
+
+		if (F.height > G.height) {
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.bounds = Union(B.bounds, G.bounds);
+			C.bounds = Union(A.bounds, F.bounds);
+			A.height = 1 + std::max(B.height, G.height);
+			C.height = 1 + std::max(A.height, F.height);
+		}
+		else {
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.bounds = Union(B.bounds, F.bounds);
+			C.bounds = Union(A.bounds, G.bounds);
+			A.height = 1 + std::max(B.height, F.height);
+			C.height = 1 + std::max(A.height, G.height);
+		}
+		return iC;
+	}
+
+	// Rotate B up
+	if (balance < -1) {
+		const int iD = B.child1;
+		const int iE = B.child2;
+		AabbTreeNode& D = nodes[iD];
+		AabbTreeNode& E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+		ReplaceChild(B.parent, iA, iB);
+
+		if (D.height > E.height) {
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.bounds = Union(C.bounds, E.bounds);
+			B.bounds = Union(A.bounds, D.bounds);
+			A.height = 1 + std::max(C.height, E.height);
+			B.height = 1 + std::max(A.height, D.height);
+		}
+		else {
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.bounds = Union(C.bounds, D.bounds);
+			B.bounds = Union(A.bounds, E.bounds);
+			A.height = 1 + std::max(C.height, D.height);
+			B.height = 1 + std::max(A.height, E.height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+AabbTreeBroadPhase::AabbTreeBroadPhase() : margin(0.1f), predictionSteps(4.0f), numReinserted(0)
+{
+}
+
+void AabbTreeBroadPhase::Clear()
+{
+	tree.Clear();
+	trackedBodies.clear();
+	proxies.clear();
+	sweptBounds.clear();
+	neighbours.clear();
+	movedBodies.clear();
+	touchedBodies.clear();
+	isMoved.clear();
+	isTouched.clear();
+}
+
+Bounds AabbTreeBroadPhase::GetFatBounds(const Body& body, const Bounds& swept, const float dt_sec) const
+{
+	// Stretch the box along the motion so a body moving at a steady
+	// speed stays inside it for a few steps before being re-inserted
+	Bounds fat = swept;
+	const Vec3 ahead = body.linearVelocity * (dt_sec * predictionSteps);
+	fat.Expand(fat.mins + ahead);
+	fat.Expand(fat.maxs + ahead);
+	fat.Expand(fat.mins - Vec3(margin));
+	fat.Expand(fat.maxs + Vec3(margin));
+	return fat;
+}
+
+void AabbTreeBroadPhase::UnlinkMovedBodies()
+{
+	// Filter each affected list once, rather than once per moved body,
+	// a large body such as the ground is linked to nearly everything
+	touchedBodies.clear();
+	for (const int body : movedBodies) {
+		for (const int other : neighbours[body]) {
+			if (!isTouched[other]) {
+				isTouched[other] = true;
+				touchedBodies.push_back(other);
+			}
+		}
+	}
+	for (const int body : movedBodies) {
+		neighbours[body].clear();
+	}
+	for (const int body : touchedBodies) {
+		std::vector<int>& links = neighbours[body];
+		links.erase(std::remove_if(links.begin(), links.end(), [&](const int other) { return isMoved[other]; }), links.end());
+		isTouched[body] = false;
+	}
+}
+
+void AabbTreeBroadPhase::Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+{
+	numReinserted = 0;
+
+	// Same bookkeeping as the sweep and prune, bodies are only appended
+	bool isPrefix = trackedBodies.size() <= bodies.size();
+	for (int i = 0; isPrefix && i < trackedBodies.size(); i++) {
+		isPrefix = (trackedBodies[i] == bodies[i]);
+	}
+	if (!isPrefix) {
+		Clear();
+	}
+
+	const int numTracked = (int)trackedBodies.size();
+	sweptBounds.resize(bodies.size());
+	isMoved.assign(bodies.size(), false);
+	isTouched.resize(bodies.size(), false);
+	movedBodies.clear();
+	for (int i = 0; i < bodies.size(); i++) {
+		const Body& body = *bodies[i];
+		if (i < numTracked && !body.IsAwake()) {
+			// Asleep, still inside the fat box it had when it stopped
+			continue;
+		}
+		sweptBounds[i] = GetSweptBounds(body, dt_sec);
+		if (i >= numTracked) {
+			trackedBodies.push_back(bodies[i]);
+			proxies.push_back(tree.CreateProxy(GetFatBounds(body, sweptBounds[i], dt_sec), i));
+			neighbours.emplace_back();
+		}
+		else if (!tree.GetFatBounds(proxies[i]).Contains(sweptBounds[i])) {
+			tree.MoveProxy(proxies[i], GetFatBounds(body, sweptBounds[i], dt_sec));
+			++numReinserted;
+		}
+		else {
+			continue;
+		}
+		isMoved[i] = true;
+		movedBodies.push_back(i);
+	}
+
+	// Fat boxes that did not change keep their overlaps, only
+	// the bodies that moved need their links rebuilt
+	UnlinkMovedBodies();
+	for (const int body : movedBodies) {
+		tree.Query(tree.GetFatBounds(proxies[body]), [&](const int other) {
+			// When both moved the one with the lower id makes the link
+			if (other != body && (!isMoved[other] || other > body)) {
+				neighbours[body].push_back(other);
+				neighbours[other].push_back(body);
+			}
+			return true;
+		});
+	}
+
+	// Fat overlaps are only candidates, the swept bounds filter them further
+	finalPairs.clear();
+	for (int i = 0; i < neighbours.size(); i++) {
+		for (const int other : neighbours[i]) {
+			if (other > i && sweptBounds[i].DoesIntersect(sweptBounds[other])) {
+				CollisionPair pair;
+				pair.a = i;
+				pair.b = other;
+				finalPairs.push_back(pair);
+			}
+		}
+	}
+}
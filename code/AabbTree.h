@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include "Broadphase.h"
+
+struct AabbTreeNode
+{
+	Bounds bounds;
+	int parent;	// next free node while the node is unused
+	int child1;
+	int child2;
+	int height;	// 0 for leaves, -1 for free nodes
+	int bodyId;
+
+	bool IsLeaf() const { return child1 == -1; }
+};
+
+// Dynamic bounding volume hierarchy. Leaves hold fattened bounds so
+// a body only gets re-inserted when it leaves its fat box, and the
+// tree is kept balanced with rotations on the way back up.
+class AabbTree
+{
+public:
+	AabbTree();
+
+	int CreateProxy(const Bounds& fatBounds, const int bodyId);
+	void DestroyProxy(const int proxy);
+	void MoveProxy(const int proxy, const Bounds& fatBounds);
+	void Clear();
+
+	const Bounds& GetFatBounds(const int proxy) const { return nodes[proxy].bounds; }
+	int GetHeight() const { return (root == -1) ? 0 : nodes[root].height; }
+
+	// Calls callback(bodyId) for every leaf overlapping the bounds,
+	// the query stops when the callback returns false
+	template<typename Callback>
+	void Query(const Bounds& bounds, Callback callback) const;
+
+private:
+	int AllocateNode();
+	void FreeNode(const int node);
+	void InsertLeaf(const int leaf);
+	void RemoveLeaf(const int leaf);
+	int Balance(const int node);
+	void ReplaceChild(const int parent, const int oldChild, const int newChild);
+
+	std::vector<AabbTreeNode> nodes;
+	int root;
+	int freeList;
+	mutable std::vector<int> queryStack;
+};
+
+template<typename Callback>
+void AabbTree::Query(const Bounds& bounds, Callback callback) const
+{
+	if (root == -1) {
+		return;
+	}
+	queryStack.clear();
+	queryStack.push_back(root);
+	while (!queryStack.empty()) {
+		const AabbTreeNode& node = nodes[queryStack.back()];
+		queryStack.pop_back();
+		if (!node.bounds.DoesIntersect(bounds)) {
+			continue;
+		}
+		if (node.IsLeaf()) {
+			if (!callback(node.bodyId)) {
+				return;
+			}
+		}
+		else {
+			queryStack.push_back(node.child1);
+			queryStack.push_back(node.child2);
+		}
+	}
+}
+
+// Broadphase backend on top of the tree. Candidate pairs are kept
+// between steps and only the bodies that left their fat box are
+// re-queried, so resting bodies cost a containment test per step.
+class AabbTreeBroadPhase : public BroadPhaseBackend
+{
+public:
+	AabbTreeBroadPhase();
+
+	BroadPhaseType GetType() const override { return BroadPhaseType::AABB_TREE; }
+	void Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec) override;
+	void Clear();
+
+	int GetNumReinserted() const { return numReinserted; }
+	int GetTreeHeight() const { return tree.GetHeight(); }
+
+private:
+	Bounds GetFatBounds(const Body& body, const Bounds& sweptBounds, const float dt_sec) const;
+	void UnlinkMovedBodies();
+
+	AabbTree tree;
+	std::vector<Body*> trackedBodies;
+	std::vector<int> proxies;
+	std::vector<Bounds> sweptBounds;
+	std::vector<std::vector<int>> neighbours;	// bodies whose fat boxes overlap
+	std::vector<int> movedBodies;
+	std::vector<int> touchedBodies;
+	std::vector<bool> isMoved;
+	std::vector<bool> isTouched;
+
+	float margin;			// added around the swept bounds
+	float predictionSteps;	// how many steps of motion the fat box covers ahead
+
+	int numReinserted;
+};
@@ -1,24 +1,58 @@
 #include "Body.h"
 #include "Shape.h"
 
+void Body::SetShape(Shape* newShape)
+{
+	shape = newShape;
+	inertiaTensorBodySpace = shape->GetInertiaTensor();
+	inverseInertiaTensorBodySpace = shape->GetInverseInertiaTensor();
+	isInertiaWorldSpaceDirty = true;
+}
+
+void Body::SetAwake(const bool awake)
+{
+	isAwake = awake;
+	sleepTime = 0.0f;
+	if (!awake) {
+		linearVelocity.Zero();
+		angularVelocity.Zero();
+	}
+}
+
 void Body::Update(const float dt_sec)
 {
-	position += linearVelocity * dt_sec;
-	Vec3 positionCM = GetCenterOfMassWorldSpace();
-	Vec3 CMToPositon = position - positionCM;
-	Mat3 orientationMat = orientation.ToMat3();
-	Mat3 inertiaTensor = orientationMat * shape->InertiaTensor() * orientationMat.Transpose();
+	Integrate(dt_sec, position, orientation, angularVelocity);
+	isInertiaWorldSpaceDirty = true;
+}
+
+void Body::GetTransformAt(const float dt_sec, Vec3& outPosition, Quat& outOrientation) const
+{
+	Vec3 newAngularVelocity;
+	Integrate(dt_sec, outPosition, outOrientation, newAngularVelocity);
+}
 
-	Vec3 alpha = inertiaTensor.Inverse() * (angularVelocity.Cross(inertiaTensor * angularVelocity));
+void Body::Integrate(const float dt_sec, Vec3& outPosition, Quat& outOrientation, Vec3& outAngularVelocity) const
+{
+	// Reads the current state only, the outputs may alias the members
+	const Vec3 newPosition = position + linearVelocity * dt_sec;
+	Vec3 positionCM = newPosition + orientation.RotatePoint(shape->GetCenterOfMass());
+	Vec3 CMToPositon = newPosition - positionCM;
+	// Gyroscopic term in body space, where the cached tensors apply as they are
+	const Quat invertOrient = orientation.Inverse();
+	const Vec3 angularVelocityBodySpace = invertOrient.RotatePoint(angularVelocity);
+	const Vec3 alphaBodySpace = inverseInertiaTensorBodySpace * angularVelocityBodySpace.Cross(inertiaTensorBodySpace * angularVelocityBodySpace);
+	Vec3 alpha = orientation.RotatePoint(alphaBodySpace);
 
-	angularVelocity += alpha * dt_sec;
+	const Vec3 newAngularVelocity = angularVelocity + alpha * dt_sec;
 	// Update orientation
-	Vec3 dAngle = angularVelocity * dt_sec;
+	Vec3 dAngle = newAngularVelocity * dt_sec;
 	Quat dq = Quat(dAngle, dAngle.GetMagnitude());
-	orientation = dq * orientation;
-	orientation.Normalize();
+	Quat newOrientation = dq * orientation;
+	newOrientation.Normalize();
 	// Get the new model position
-	position = positionCM + dq.RotatePoint(CMToPositon);
+	outPosition = positionCM + dq.RotatePoint(CMToPositon);
+	outOrientation = newOrientation;
+	outAngularVelocity = newAngularVelocity;
 }
 
 Vec3 Body::GetCenterOfMassWorldSpace() const
@@ -53,30 +87,36 @@ Vec3 Body::BodySpaceToWorldSpace(const Vec3& bodyPoint)
 void Body::ApplyImpulseLinear(const Vec3& impulse)
 {
 	if (inverseMass == 0.0f) return;
+	isAwake = true;
 	// dv = J / m
 	linearVelocity += impulse * inverseMass;
 }
 
 Mat3 Body::GetInverseInertiaTensorBodySpace() const
 {
-	Mat3 inertiaTensor = shape->InertiaTensor();
-	Mat3 inverseInertiaTensor = inertiaTensor.Inverse() * inverseMass;
-	return inverseInertiaTensor;
+	return inverseInertiaTensorBodySpace * inverseMass;
 }
 Mat3 Body::GetInverseInertiaTensorWorldSpace() const
 {
-	Mat3 inertiaTensor = shape->InertiaTensor();
-	Mat3 inverseInertiaTensor = inertiaTensor.Inverse() * inverseMass;
-	Mat3 orient = orientation.ToMat3();
-	inverseInertiaTensor = orient * inverseInertiaTensor
-	* orient.Transpose();
-
-	return inverseInertiaTensor;
+	if (inverseMass == 0.0f) {
+		// Static bodies may be shared by threads, leave the cache alone
+		Mat3 zero;
+		zero.Zero();
+		return zero;
+	}
+	if (isInertiaWorldSpaceDirty) {
+		Mat3 orient = orientation.ToMat3();
+		inverseInertiaTensorWorldSpace = orient * inverseInertiaTensorBodySpace
+		* orient.Transpose();
+		isInertiaWorldSpaceDirty = false;
+	}
+	return inverseInertiaTensorWorldSpace * inverseMass;
 }
 
 void Body::ApplyImpulseAngular(const Vec3& impulse)
 {
 	if (inverseMass == 0.0f) return;
+	isAwake = true;
 	// L = I w = r x p
 	// dL = I dw = r x J
 	// dw = I^-1 * ( r x J )
@@ -1,8 +1,10 @@
 #pragma once
 #include "Math/Vector.h"
-#include "Renderer/model.h"
+#include "Math/Matrix.h"
 #include "Math/Quat.h"
 
+class Shape;
+
 class Body
 {
 public:
@@ -15,9 +17,22 @@ public:
 	float elasticity;
 	float friction;
 	
+	// Assign through SetShape, which caches the inertia of the shape
 	Shape* shape;
+
+	// Time the body has spent under the sleep thresholds, the scene puts it
+	// to sleep once its whole island has rested long enough. A sleeping body
+	// is not integrated, an impulse or a contact with an awake body wakes it.
+	float sleepTime = 0.0f;
+
+	void SetShape(Shape* newShape);
+
+	bool IsAwake() const { return isAwake; }
+	void SetAwake(const bool awake);
 	
 	void Update(const float dt_sec);
+	// Where Update(dt_sec) would put the body, leaving it untouched
+	void GetTransformAt(const float dt_sec, Vec3& outPosition, Quat& outOrientation) const;
 	
 	Vec3 GetCenterOfMassWorldSpace() const;
 	Vec3 GetCenterOfMassBodySpace() const;
@@ -29,5 +44,18 @@ public:
 	void ApplyImpulse(const Vec3& impulsePoint, const Vec3& impulse);
 	
 	Mat3 GetInverseInertiaTensorBodySpace() const;
+	// Rotated to the current orientation by the first call after the body
+	// moved, call it from the thread stepping the body
 	Mat3 GetInverseInertiaTensorWorldSpace() const;
+
+private:
+	bool isAwake = true;
+
+	// Per unit mass, inverseMass may change after the shape is set
+	Mat3 inertiaTensorBodySpace;
+	Mat3 inverseInertiaTensorBodySpace;
+	mutable Mat3 inverseInertiaTensorWorldSpace;
+	mutable bool isInertiaWorldSpaceDirty = true;
+
+	void Integrate(const float dt_sec, Vec3& outPosition, Quat& outOrientation, Vec3& outAngularVelocity) const;
 };
\ No newline at end of file
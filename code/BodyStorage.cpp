@@ -0,0 +1,74 @@
+#include "BodyStorage.h"
+
+BodyHandle BodyStorage::Add()
+{
+	uint32_t slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = (uint32_t)generations.size();
+		generations.push_back(0);
+		slotIndices.push_back(-1);
+	}
+
+	slotIndices[slot] = Size();
+	indexSlots.push_back(slot);
+
+	BodyHandle handle;
+	handle.slot = slot;
+	handle.generation = generations[slot];
+	return handle;
+}
+
+void BodyStorage::Remove(const BodyHandle handle)
+{
+	const int index = GetIndex(handle);
+	if (index < 0) {
+		return;
+	}
+
+	// The last body takes the index of the removed one
+	const int last = Size() - 1;
+	if (index != last) {
+		indexSlots[index] = indexSlots[last];
+		slotIndices[indexSlots[index]] = index;
+	}
+	indexSlots.pop_back();
+
+	slotIndices[handle.slot] = -1;
+	++generations[handle.slot];
+	freeSlots.push_back(handle.slot);
+}
+
+void BodyStorage::Clear()
+{
+	for (const uint32_t slot : indexSlots) {
+		slotIndices[slot] = -1;
+		++generations[slot];
+		freeSlots.push_back(slot);
+	}
+	indexSlots.clear();
+}
+
+bool BodyStorage::IsValid(const BodyHandle handle) const
+{
+	return GetIndex(handle) >= 0;
+}
+
+int BodyStorage::GetIndex(const BodyHandle handle) const
+{
+	if (handle.slot >= generations.size() || generations[handle.slot] != handle.generation) {
+		return -1;
+	}
+	return slotIndices[handle.slot];
+}
+
+BodyHandle BodyStorage::GetHandle(const int index) const
+{
+	BodyHandle handle;
+	handle.slot = indexSlots[index];
+	handle.generation = generations[handle.slot];
+	return handle;
+}
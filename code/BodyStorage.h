@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Names a body of a BodyStorage. The generation of a slot goes up every time
+// its body is removed, so a handle kept past the removal no longer resolves,
+// even once the slot holds another body.
+struct BodyHandle
+{
+	static const uint32_t INVALID_SLOT = 0xffffffff;
+
+	uint32_t slot = INVALID_SLOT;
+	uint32_t generation = 0;
+
+	bool operator==(const BodyHandle& rhs) const { return slot == rhs.slot && generation == rhs.generation; }
+	bool operator!=(const BodyHandle& rhs) const { return !(*this == rhs); }
+};
+
+// Maps the handles of a scene's bodies to their index in Scene::bodies.
+// The owner keeps its own array in step: Add names the index appended
+// last, and Remove moves the last index into the removed one, so the
+// owner swaps its last element into the same place. The handle of the
+// moved body stays valid, its index does not.
+class BodyStorage
+{
+public:
+	BodyHandle Add();
+	void Remove(const BodyHandle handle);
+	// Removes every body, the handles given so far no longer resolve
+	void Clear();
+
+	bool IsValid(const BodyHandle handle) const;
+	// -1 when the handle does not resolve
+	int GetIndex(const BodyHandle handle) const;
+	BodyHandle GetHandle(const int index) const;
+
+	int Size() const { return (int)indexSlots.size(); }
+
+private:
+	std::vector<uint32_t> generations;	// per slot
+	std::vector<int> slotIndices;		// per slot, -1 while free
+	std::vector<uint32_t> indexSlots;	// per index
+	std::vector<uint32_t> freeSlots;
+};
@@ -1,30 +1,35 @@
 ﻿#include "Broadphase.h"
 #include "Math/Bounds.h"
+#include "Math/BoundsSoA.h"
+#include "FrameArena.h"
+#include "RadixSort.h"
 #include "Shape.h"
+#include "SweepAndPrune.h"
+#include "AabbTree.h"
+#include "SpatialHashGrid.h"
 
-int CompareSAP(const void* a, const void* b) {
-	const PseudoBody* ea = (const PseudoBody*)a;
-	const PseudoBody* eb = (const PseudoBody*)b;
-	if (ea->value < eb->value) {
-		return -1;
-	}
-	return 1;
+#include <string.h>
+
+Bounds GetSweptBounds(const Body& body, const float dt_sec)
+{
+	Bounds bounds =	body.shape->GetBounds(body.position, body.orientation);
+	// Expand the bounds by the linear velocity
+	bounds.Expand(bounds.mins + body.linearVelocity * dt_sec);
+	bounds.Expand(bounds.maxs + body.linearVelocity * dt_sec);
+	const float epsilon = 0.01f;
+	bounds.Expand(bounds.mins + Vec3(-1, -1, -1) * epsilon);
+	bounds.Expand(bounds.maxs + Vec3(1, 1, 1) * epsilon);
+	return bounds;
 }
 
-void SortBodiesBounds(const std::vector<Body*>& bodies, PseudoBody* sortedArray, const float dt_sec)
+void SortBodiesBounds(const std::vector<Body*>& bodies, PseudoBody* sortedArray, Bounds* boundsArray, const float dt_sec, FrameArena& arena)
 {
 	Vec3 axis = Vec3(1, 1, 1);
 	axis.Normalize();
 	for (int i = 0; i < bodies.size(); i++)
 	{
-		const Body& body = *bodies[i];
-		Bounds bounds =	body.shape->GetBounds(body.position, body.orientation);
-		// Expand the bounds by the linear velocity
-		bounds.Expand(bounds.mins + body.linearVelocity * dt_sec);
-		bounds.Expand(bounds.maxs + body.linearVelocity * dt_sec);
-		const float epsilon = 0.01f;
-		bounds.Expand(bounds.mins + Vec3(-1, -1, -1) * epsilon);
-		bounds.Expand(bounds.maxs + Vec3(1, 1, 1) * epsilon);
+		const Bounds bounds = GetSweptBounds(*bodies[i], dt_sec);
+		boundsArray[i] = bounds;
 		sortedArray[i * 2 + 0].id = i;
 		sortedArray[i * 2 + 0].value = axis.Dot(bounds.mins);
 		sortedArray[i * 2 + 0].ismin = true;
@@ -32,51 +37,213 @@ void SortBodiesBounds(const std::vector<Body*>& bodies, PseudoBody* sortedArray,
 		sortedArray[i * 2 + 1].value = axis.Dot(bounds.maxs);
 		sortedArray[i * 2 + 1].ismin = false;
 	}
-	qsort(sortedArray, bodies.size() * 2, sizeof(PseudoBody), CompareSAP);
+	RadixSortEndpoints(sortedArray, (int)bodies.size() * 2, &arena);
 }
 
 void BuildPairs(std::vector< CollisionPair >& collisionPairs,
-const PseudoBody* sortedBodies, const int num)
+const PseudoBody* sortedBodies, const Bounds* bounds, const int num, PairFilterStats* filterStats, FrameArena& arena)
 {
 	collisionPairs.clear();
-	// Now that the bodies are sorted, build the collision pairs
+	// Number the bodies in the order of their min endpoint, the bodies whose
+	// min lies within the interval of a body are then a contiguous run after
+	// it, which lets the 3D overlap test run over packed arrays
+	int* order = arena.Allocate<int>(num);
+	int* runEnd = arena.Allocate<int>(num);
+	int numMins = 0;
 	for (int i = 0; i < num * 2; i++) {
-		const PseudoBody& a = sortedBodies[i];
-		if (!a.ismin) {
+		const PseudoBody& endpoint = sortedBodies[i];
+		if (endpoint.ismin) {
+			order[numMins++] = endpoint.id;
+		}
+		else {
+			runEnd[endpoint.id] = numMins;
+		}
+	}
+
+	BoundsSoA packedBounds;
+	packedBounds.Resize(num, arena);
+	for (int i = 0; i < num; i++) {
+		packedBounds.Set(i, bounds[order[i]]);
+	}
+
+	// Now that the bodies are sorted, build the collision pairs
+	int* overlapping = arena.Allocate<int>(num);
+	int numCandidates = 0;
+	for (int i = 0; i < num; i++) {
+		const int last = runEnd[order[i]];
+		if (last <= i + 1) {
 			continue;
 		}
+		numCandidates += last - (i + 1);
+		const int numOverlapping = packedBounds.OverlapRun(i, i + 1, last, overlapping);
 		CollisionPair pair;
-		pair.a = a.id;
-		for (int j = i + 1; j < num * 2; j++) {
-			const PseudoBody& b = sortedBodies[j];
-			// if we've hit the end of the a element,
-			// then we're done creating pairs with a
-			if (b.id == a.id) {
-				break;
-			}
-			if (!b.ismin) {
-				continue;
-			}
-			pair.b = b.id;
+		pair.a = order[i];
+		for (int j = 0; j < numOverlapping; j++) {
+			pair.b = order[overlapping[j]];
 			collisionPairs.push_back(pair);
 		}
 	}
+
+	if (filterStats != nullptr) {
+		filterStats->numCandidatePairs = numCandidates;
+		filterStats->numRejectedPairs = numCandidates - (int)collisionPairs.size();
+	}
 }
 
-void SweepAndPrune1D(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+void SweepAndPrune1D(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec, PairFilterStats* filterStats, FrameArena& arena)
 {
 	// Allocation mémoire pour un tableau de PseudoBody
-	PseudoBody* sortedBodies = (PseudoBody*)alloca(sizeof(PseudoBody) * bodies.size() * 2);
+	// (dans l'arène de l'étape, la pile ne tient pas au-delà de quelques centaines de corps)
+	const int num = (int)bodies.size();
+	PseudoBody* sortedBodies = arena.Allocate<PseudoBody>(num * 2);
+	Bounds* bounds = arena.Allocate<Bounds>(num);
 
 	// Tri des objets en fonction de leurs bornes
-	SortBodiesBounds(bodies, sortedBodies, dt_sec);
+	SortBodiesBounds(bodies, sortedBodies, bounds, dt_sec, arena);
 
 	// Construction des paires de collisions
-	BuildPairs(finalPairs, sortedBodies, bodies.size());
+	BuildPairs(finalPairs, sortedBodies, bounds, num, filterStats, arena);
 }
 
-void BroadPhase(const std::vector<Body*>& bodies, std::vector< CollisionPair >& finalPairs, const float dt_sec)
+void BroadPhase(const std::vector<Body*>& bodies, std::vector< CollisionPair >& finalPairs, const float dt_sec, PairFilterStats* filterStats, FrameArena* arena)
 {
 	finalPairs.clear();
-	SweepAndPrune1D(bodies, finalPairs, dt_sec);
+	if (arena != nullptr) {
+		SweepAndPrune1D(bodies, finalPairs, dt_sec, filterStats, *arena);
+		return;
+	}
+	// Called outside of a step, the scratch lives for this call only
+	// (endpoints, bounds, packed bounds, pair build arrays and the sort buffers come to about 160 bytes a body)
+	FrameArena localArena(bodies.size() * 160 + 4096);
+	SweepAndPrune1D(bodies, finalPairs, dt_sec, filterStats, localArena);
+}
+
+void BroadPhaseBackend::FindPairs(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+{
+	dynamicBodies.clear();
+	dynamicIndices.clear();
+	staticIndices.clear();
+	for (int i = 0; i < bodies.size(); i++) {
+		if (bodies[i]->inverseMass == 0.0f) {
+			staticIndices.push_back(i);
+		}
+		else {
+			dynamicBodies.push_back(bodies[i]);
+			dynamicIndices.push_back(i);
+		}
+	}
+
+	// The backend only sees dynamic bodies, map its pairs back to scene ids.
+	// Two sleeping bodies stay where they are, their pair needs no contact.
+	Update(dynamicBodies, dynamicPairs, dt_sec);
+	finalPairs.clear();
+	finalPairs.reserve(dynamicPairs.size());
+	for (int i = 0; i < dynamicPairs.size(); i++) {
+		if (!dynamicBodies[dynamicPairs[i].a]->IsAwake() && !dynamicBodies[dynamicPairs[i].b]->IsAwake()) {
+			continue;
+		}
+		CollisionPair pair;
+		pair.a = dynamicIndices[dynamicPairs[i].a];
+		pair.b = dynamicIndices[dynamicPairs[i].b];
+		finalPairs.push_back(pair);
+	}
+
+	FindStaticPairs(bodies, finalPairs, dt_sec);
+}
+
+void BroadPhaseBackend::FindStaticPairs(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+{
+	numStaticPairs = 0;
+	for (int i = 0; i < staticIndices.size(); i++) {
+		const Body& staticBody = *bodies[staticIndices[i]];
+		const Bounds staticBounds = GetSweptBounds(staticBody, dt_sec);
+		const bool isStaticSphere = staticBody.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE;
+
+		for (int j = 0; j < dynamicBodies.size(); j++) {
+			const Body& body = *dynamicBodies[j];
+			if (!body.IsAwake()) {
+				continue;
+			}
+			if (isStaticSphere && body.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE) {
+				// Ground contact test, the gap between the spheres must
+				// be covered by the motion of this step (plus the bounds epsilon)
+				const float radiusA = static_cast<const ShapeSphere*>(staticBody.shape)->radius;
+				const float radiusB = static_cast<const ShapeSphere*>(body.shape)->radius;
+				const float reach = radiusA + radiusB + body.linearVelocity.GetMagnitude() * dt_sec + 0.02f;
+				if ((body.position - staticBody.position).GetLengthSqr() > reach * reach) {
+					continue;
+				}
+			}
+			else if (!staticBounds.DoesIntersect(GetSweptBounds(body, dt_sec))) {
+				continue;
+			}
+			CollisionPair pair;
+			pair.a = staticIndices[i];
+			pair.b = dynamicIndices[j];
+			finalPairs.push_back(pair);
+			++numStaticPairs;
+		}
+	}
+}
+
+void BroadPhase(BroadPhaseBackend& backend, const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+{
+	backend.FindPairs(bodies, finalPairs, dt_sec);
+}
+
+// The original stateless sweep, kept as a backend for comparisons
+class SweepAndPrune1DBackend : public BroadPhaseBackend
+{
+public:
+	BroadPhaseType GetType() const override { return BroadPhaseType::SWEEP_AND_PRUNE_1D; }
+	void Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec) override
+	{
+		BroadPhase(bodies, finalPairs, dt_sec, nullptr, frameArena);
+	}
+};
+
+BroadPhaseBackend* CreateBroadPhase(const BroadPhaseType type)
+{
+	switch (type) {
+	case BroadPhaseType::SWEEP_AND_PRUNE_1D:
+		return new SweepAndPrune1DBackend();
+	case BroadPhaseType::SWEEP_AND_PRUNE: {
+		SweepAndPrune* sweepAndPrune = new SweepAndPrune();
+		sweepAndPrune->SetAxisMode(SapAxisMode::PRINCIPAL_AXIS);
+		return sweepAndPrune;
+	}
+	case BroadPhaseType::AABB_TREE:
+		return new AabbTreeBroadPhase();
+	case BroadPhaseType::HASH_GRID:
+		return new SpatialHashGrid();
+	}
+	return nullptr;
+}
+
+const char* BroadPhaseTypeName(const BroadPhaseType type)
+{
+	switch (type) {
+	case BroadPhaseType::SWEEP_AND_PRUNE_1D: return "sap1d";
+	case BroadPhaseType::SWEEP_AND_PRUNE: return "sap";
+	case BroadPhaseType::AABB_TREE: return "tree";
+	case BroadPhaseType::HASH_GRID: return "grid";
+	}
+	return "unknown";
+}
+
+bool ParseBroadPhaseType(const char* name, BroadPhaseType& type)
+{
+	const BroadPhaseType types[] = {
+		BroadPhaseType::SWEEP_AND_PRUNE_1D,
+		BroadPhaseType::SWEEP_AND_PRUNE,
+		BroadPhaseType::AABB_TREE,
+		BroadPhaseType::HASH_GRID,
+	};
+	for (const BroadPhaseType candidate : types) {
+		if (strcmp(name, BroadPhaseTypeName(candidate)) == 0) {
+			type = candidate;
+			return true;
+		}
+	}
+	return false;
 }
\ No newline at end of file
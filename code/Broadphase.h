@@ -1,6 +1,9 @@
 ﻿#pragma once
 #include <vector>
 #include "Body.h"
+#include "Math/Bounds.h"
+
+class FrameArena;
 
 struct CollisionPair
 {
@@ -22,4 +25,62 @@ struct PseudoBody
 	bool ismin;
 };
 
-void BroadPhase(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec);
\ No newline at end of file
+enum class BroadPhaseType
+{
+	SWEEP_AND_PRUNE_1D,	// stateless sweep along the diagonal, rebuilt every step
+	SWEEP_AND_PRUNE,	// persistent, incremental sweep and prune
+	AABB_TREE,		// dynamic bounding volume hierarchy
+	HASH_GRID,		// uniform grid for many bodies of similar size
+};
+
+// A broadphase that keeps state between steps, the scene
+// owns one and the backend can be swapped at runtime
+class BroadPhaseBackend
+{
+public:
+	virtual ~BroadPhaseBackend() {}
+
+	virtual BroadPhaseType GetType() const = 0;
+	virtual void Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec) = 0;
+
+	// Static bodies (infinite mass) never enter the backend, they are
+	// tested against each dynamic body on their own so that a huge body
+	// such as the ground does not pair with everything in the structure.
+	// Pairs without an awake body are dropped, backends may skip the
+	// bounds of sleeping bodies since those do not move.
+	void FindPairs(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec);
+
+	int GetNumStaticBodies() const { return (int)staticIndices.size(); }
+	int GetNumStaticPairs() const { return numStaticPairs; }
+
+	// Transient scratch for the step, reset by the owner once the step is done
+	void SetFrameArena(FrameArena* arena) { frameArena = arena; }
+
+protected:
+	FrameArena* frameArena = nullptr;
+
+private:
+	void FindStaticPairs(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec);
+
+	std::vector<Body*> dynamicBodies;
+	std::vector<int> dynamicIndices;
+	std::vector<int> staticIndices;
+	std::vector<CollisionPair> dynamicPairs;
+	int numStaticPairs = 0;
+};
+
+BroadPhaseBackend* CreateBroadPhase(const BroadPhaseType type);
+const char* BroadPhaseTypeName(const BroadPhaseType type);
+bool ParseBroadPhaseType(const char* name, BroadPhaseType& type);
+
+// Pairs overlapping on the sweep axis are only candidates,
+// those whose boxes miss on another axis are rejected
+struct PairFilterStats
+{
+	int numCandidatePairs = 0;
+	int numRejectedPairs = 0;
+};
+
+Bounds GetSweptBounds(const Body& body, const float dt_sec);
+void BroadPhase(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec, PairFilterStats* filterStats = nullptr, FrameArena* arena = nullptr);
+void BroadPhase(BroadPhaseBackend& backend, const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec);
\ No newline at end of file
@@ -67,15 +67,20 @@ void Contact::ResolveContact(Contact& contact)
 		const float tA = invMassA / (invMassA + invMassB);
 		const float tB = invMassB / (invMassA + invMassB);
 		const Vec3 d = ptOnB - ptOnA;
-		a->position += d * tA;
-		b->position -= d * tB;
+		// Static bodies are shared between islands, leave them untouched
+		if (invMassA != 0.0f) {
+			a->position += d * tA;
+		}
+		if (invMassB != 0.0f) {
+			b->position -= d * tB;
+		}
 	}
 }
 
 int Contact::CompareContact(const void* p1, const void* p2)
 {
 	const Contact& a = *(Contact*)p1;
-	const Contact& b = *(Contact*)p1;
+	const Contact& b = *(Contact*)p2;
 	if (a.timeOfImpact < b.timeOfImpact) {
 		return -1;
 	}
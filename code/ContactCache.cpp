@@ -0,0 +1,174 @@
+#include "ContactCache.h"
+
+#include <algorithm>
+#include <utility>
+
+// How far a cached point may drift, apart along the normal or sideways,
+// before it no longer describes the contact and is dropped
+static const float CONTACT_BREAKING_THRESHOLD = 0.02f;
+// A new contact closer than this to a cached point is the same contact
+static const float CONTACT_MATCH_THRESHOLD = 0.02f;
+
+uint64_t ContactCache::PairKey(const BodyHandle a, const BodyHandle b)
+{
+	const uint32_t lo = std::min(a.slot, b.slot);
+	const uint32_t hi = std::max(a.slot, b.slot);
+	return ((uint64_t)lo << 32) | hi;
+}
+
+static void RemovePoint(ContactManifold& manifold, const int index)
+{
+	manifold.points[index] = manifold.points[manifold.numPoints - 1];
+	--manifold.numPoints;
+}
+
+void ContactCache::Refresh(const std::vector<Body*>& bodies, const BodyStorage& storage, ContactManifold& manifold)
+{
+	if (manifold.refreshStep == step) {
+		return;
+	}
+	manifold.refreshStep = step;
+	Body& bodyA = *bodies[storage.GetIndex(manifold.a)];
+	Body& bodyB = *bodies[storage.GetIndex(manifold.b)];
+	for (int i = manifold.numPoints - 1; i >= 0; i--) {
+		ContactPoint& point = manifold.points[i];
+		point.ptOnAWorldSpace = bodyA.BodySpaceToWorldSpace(point.ptOnALocalSpace);
+		point.ptOnBWorldSpace = bodyB.BodySpaceToWorldSpace(point.ptOnBLocalSpace);
+		const Vec3 delta = point.ptOnAWorldSpace - point.ptOnBWorldSpace;
+		point.separation = delta.Dot(manifold.normal);
+		const Vec3 drift = delta - manifold.normal * point.separation;
+		if (point.separation > CONTACT_BREAKING_THRESHOLD
+		|| drift.GetLengthSqr() > CONTACT_BREAKING_THRESHOLD * CONTACT_BREAKING_THRESHOLD) {
+			RemovePoint(manifold, i);
+		}
+	}
+}
+
+ContactPoint& ContactCache::AddContact(const std::vector<Body*>& bodies, const BodyStorage& storage, const CollisionPair& pair, Contact& contact)
+{
+	BodyHandle handleA = storage.GetHandle(pair.a);
+	BodyHandle handleB = storage.GetHandle(pair.b);
+	if (handleA.slot > handleB.slot) {
+		std::swap(handleA, handleB);
+		std::swap(contact.a, contact.b);
+		std::swap(contact.ptOnAWorldSpace, contact.ptOnBWorldSpace);
+		std::swap(contact.ptOnALocalSpace, contact.ptOnBLocalSpace);
+		contact.normal = contact.normal * -1.0f;
+	}
+
+	const uint64_t key = PairKey(handleA, handleB);
+	auto found = manifolds.find(key);
+	if (found == manifolds.end()) {
+		ContactManifold manifold{};
+		manifold.a = handleA;
+		manifold.b = handleB;
+		manifold.numPoints = 0;
+		manifold.refreshStep = step;
+		found = manifolds.emplace(key, manifold).first;
+	}
+	ContactManifold& manifold = found->second;
+	Refresh(bodies, storage, manifold);
+	manifold.normal = contact.normal;
+	manifold.lastStep = step;
+
+	// The narrow phase gives the points at the time of impact,
+	// the cache and the solver work at the start of the step
+	Body& bodyA = *contact.a;
+	Body& bodyB = *contact.b;
+	const Vec3 ptOnA = contact.ptOnAWorldSpace - bodyA.linearVelocity * contact.timeOfImpact;
+	const Vec3 ptOnB = contact.ptOnBWorldSpace - bodyB.linearVelocity * contact.timeOfImpact;
+
+	int match = -1;
+	float closestSqr = CONTACT_MATCH_THRESHOLD * CONTACT_MATCH_THRESHOLD;
+	for (int i = 0; i < manifold.numPoints; i++) {
+		const float distanceSqr = (manifold.points[i].ptOnAWorldSpace - ptOnA).GetLengthSqr();
+		if (distanceSqr < closestSqr) {
+			closestSqr = distanceSqr;
+			match = i;
+		}
+	}
+
+	if (match >= 0) {
+		++matchedThisStep;
+	}
+	else {
+		if (manifold.numPoints < ContactManifold::MAX_POINTS) {
+			match = manifold.numPoints++;
+		}
+		else {
+			// Full, the shallowest point matters the least
+			match = 0;
+			for (int i = 1; i < manifold.numPoints; i++) {
+				if (manifold.points[i].separation > manifold.points[match].separation) {
+					match = i;
+				}
+			}
+		}
+		manifold.points[match].normalImpulse = 0.0f;
+		manifold.points[match].frictionImpulse.Zero();
+	}
+
+	ContactPoint& point = manifold.points[match];
+	point.ptOnAWorldSpace = ptOnA;
+	point.ptOnBWorldSpace = ptOnB;
+	point.ptOnALocalSpace = bodyA.WorldSpaceToBodySpace(ptOnA);
+	point.ptOnBLocalSpace = bodyB.WorldSpaceToBodySpace(ptOnB);
+	point.separation = (ptOnA - ptOnB).Dot(manifold.normal);
+	point.lastStep = step;
+	return point;
+}
+
+const ContactManifold* ContactCache::Find(const BodyHandle a, const BodyHandle b) const
+{
+	const auto found = manifolds.find(PairKey(a, b));
+	if (found == manifolds.end()) {
+		return nullptr;
+	}
+	// The slots may have been reused since
+	const ContactManifold& manifold = found->second;
+	const bool sameBodies = (manifold.a == a && manifold.b == b) || (manifold.a == b && manifold.b == a);
+	return sameBodies ? &manifold : nullptr;
+}
+
+void ContactCache::EndStep()
+{
+	numExpired = 0;
+	for (auto it = manifolds.begin(); it != manifolds.end();) {
+		ContactManifold& manifold = it->second;
+		for (int i = manifold.numPoints - 1; i >= 0; i--) {
+			if (step - manifold.points[i].lastStep > maxIdleSteps) {
+				RemovePoint(manifold, i);
+			}
+		}
+		if (manifold.numPoints == 0 || step - manifold.lastStep > maxIdleSteps) {
+			it = manifolds.erase(it);
+			++numExpired;
+		}
+		else {
+			++it;
+		}
+	}
+	numMatched = matchedThisStep;
+	matchedThisStep = 0;
+	++step;
+}
+
+void ContactCache::RemoveBody(const BodyHandle handle)
+{
+	for (auto it = manifolds.begin(); it != manifolds.end();) {
+		if (it->second.a.slot == handle.slot || it->second.b.slot == handle.slot) {
+			it = manifolds.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void ContactCache::Clear()
+{
+	manifolds.clear();
+	numMatched = 0;
+	matchedThisStep = 0;
+	numExpired = 0;
+}
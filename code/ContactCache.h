@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "BodyStorage.h"
+#include "Broadphase.h"
+#include "Contact.h"
+
+// A contact point that outlives the step it was found in. The points are
+// kept in the local space of each body so they follow the bodies, and the
+// impulses the solver needed last time seed the next solve (warm start).
+struct ContactPoint
+{
+	Vec3 ptOnALocalSpace;
+	Vec3 ptOnBLocalSpace;
+	Vec3 ptOnAWorldSpace;
+	Vec3 ptOnBWorldSpace;
+	float separation = 0.0f;		// along the manifold normal, negative when overlapping
+	float normalImpulse = 0.0f;
+	Vec3 frictionImpulse;	// world space, acting on body A
+	uint32_t lastStep = 0;		// last step the narrow phase reported this point
+};
+
+// The points shared by a pair of bodies. A is always the body with the
+// lower handle slot, the normal points from B to A.
+struct ContactManifold
+{
+	static const int MAX_POINTS = 4;
+
+	BodyHandle a;
+	BodyHandle b;
+	Vec3 normal;
+	int numPoints = 0;
+	ContactPoint points[MAX_POINTS];
+	uint32_t lastStep = 0;		// last step any of the points was reported
+	uint32_t refreshStep = 0;	// last step the points were moved to the current transforms
+};
+
+// Contact manifolds kept from one step to the next, keyed by the body pair.
+// Each step the narrow phase contacts are merged in: the cached points are
+// refreshed from the body transforms (a transform per point, no shape test),
+// those that drifted apart are dropped and a new contact close to a cached
+// point takes over its impulses. Pairs not seen for a few steps expire.
+// Keys are the slots of the body handles, which stay put while bodies move
+// between indices, so removing a body only drops the manifolds it is in.
+class ContactCache
+{
+public:
+	// Flips the contact so that A is the lower handle slot, then finds or adds
+	// its point. The point stays valid until EndStep, it may be written to.
+	ContactPoint& AddContact(const std::vector<Body*>& bodies, const BodyStorage& storage, const CollisionPair& pair, Contact& contact);
+
+	// Moves the cached points of a manifold to the current body transforms
+	// and drops those that no longer touch, done once per step and manifold
+	void Refresh(const std::vector<Body*>& bodies, const BodyStorage& storage, ContactManifold& manifold);
+
+	const ContactManifold* Find(const BodyHandle a, const BodyHandle b) const;
+
+	// Expires the points and manifolds idle for longer than the limit
+	void EndStep();
+	// Drops the manifolds of a body leaving the scene, before its handle is released
+	void RemoveBody(const BodyHandle handle);
+	void Clear();
+
+	void SetMaxIdleSteps(const int steps) { maxIdleSteps = (uint32_t)steps; }
+	int GetNumManifolds() const { return (int)manifolds.size(); }
+	// Contacts of the last step that matched a cached point
+	int GetNumMatched() const { return numMatched; }
+	int GetNumExpired() const { return numExpired; }
+
+	static uint64_t PairKey(const BodyHandle a, const BodyHandle b);
+
+private:
+	std::unordered_map<uint64_t, ContactManifold> manifolds;
+	uint32_t step = 1;
+	uint32_t maxIdleSteps = 2;
+	int matchedThisStep = 0;
+	int numMatched = 0;
+	int numExpired = 0;
+};
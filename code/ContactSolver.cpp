@@ -0,0 +1,257 @@
+#include "ContactSolver.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Penetration allowed before pushing apart, and the share of the rest pushed out per step
+static const float PENETRATION_SLOP = 0.005f;
+static const float BAUMGARTE = 0.2f;
+// Below this closing speed contacts do not bounce, resting piles would never settle
+static const float RESTITUTION_THRESHOLD = 0.5f;
+// Same limit as Body::ApplyImpulseAngular
+static const float MAX_ANGULAR_SPEED = 30.0f;
+// Below this a color is solved on one thread, waking the workers costs more
+static const int MIN_CONTACTS_PER_BLOCK = 64;
+
+static float EffectiveMass(const ContactConstraint& c, const Vec3& axis)
+{
+	const Vec3 angularA = (c.inverseInertiaA * c.rA.Cross(axis)).Cross(c.rA);
+	const Vec3 angularB = (c.inverseInertiaB * c.rB.Cross(axis)).Cross(c.rB);
+	const float k = c.a->inverseMass + c.b->inverseMass + (angularA + angularB).Dot(axis);
+	return (k > 0.0f) ? 1.0f / k : 0.0f;
+}
+
+static Vec3 RelativeVelocity(const ContactConstraint& c)
+{
+	const Vec3 velA = c.a->linearVelocity + c.a->angularVelocity.Cross(c.rA);
+	const Vec3 velB = c.b->linearVelocity + c.b->angularVelocity.Cross(c.rB);
+	return velA - velB;
+}
+
+// Impulse on A, the opposite on B. Static bodies are left alone, they
+// may be in contact with bodies of islands solved on other threads.
+static void ApplyImpulse(ContactConstraint& c, const Vec3& impulse)
+{
+	if (c.a->inverseMass != 0.0f) {
+		c.a->linearVelocity += impulse * c.a->inverseMass;
+		c.a->angularVelocity += c.inverseInertiaA * c.rA.Cross(impulse);
+	}
+	if (c.b->inverseMass != 0.0f) {
+		c.b->linearVelocity -= impulse * c.b->inverseMass;
+		c.b->angularVelocity -= c.inverseInertiaB * c.rB.Cross(impulse);
+	}
+}
+
+static void PrepareConstraint(const Contact& contact, ContactPoint* point, const float inverseDt, ContactConstraint& c)
+{
+	c.a = contact.a;
+	c.b = contact.b;
+	c.inverseInertiaA = c.a->GetInverseInertiaTensorWorldSpace();
+	c.inverseInertiaB = c.b->GetInverseInertiaTensorWorldSpace();
+	c.normal = contact.normal;
+	c.normal.GetOrtho(c.tangents[0], c.tangents[1]);
+
+	// The cache moved the points to the start of the step
+	c.point = point;
+	c.rA = point->ptOnAWorldSpace - c.a->GetCenterOfMassWorldSpace();
+	c.rB = point->ptOnBWorldSpace - c.b->GetCenterOfMassWorldSpace();
+	const float separation = point->separation;
+
+	c.normalMass = EffectiveMass(c, c.normal);
+	c.tangentMass[0] = EffectiveMass(c, c.tangents[0]);
+	c.tangentMass[1] = EffectiveMass(c, c.tangents[1]);
+	c.friction = c.a->friction * c.b->friction;
+
+	if (separation > 0.0f) {
+		// Speculative, the bodies may still close the gap
+		c.velocityBias = -separation * inverseDt;
+	}
+	else {
+		c.velocityBias = BAUMGARTE * std::max(-separation - PENETRATION_SLOP, 0.0f) * inverseDt;
+		const float normalVelocity = RelativeVelocity(c).Dot(c.normal);
+		if (normalVelocity < -RESTITUTION_THRESHOLD) {
+			const float elasticity = c.a->elasticity * c.b->elasticity;
+			c.velocityBias = std::max(c.velocityBias, -elasticity * normalVelocity);
+		}
+	}
+}
+
+// Applies what this contact needed last step, zero for a new one
+static void WarmStart(ContactConstraint& c)
+{
+	c.normalImpulse = c.point->normalImpulse;
+	c.tangentImpulse[0] = c.point->frictionImpulse.Dot(c.tangents[0]);
+	c.tangentImpulse[1] = c.point->frictionImpulse.Dot(c.tangents[1]);
+	if (c.normalImpulse != 0.0f || c.tangentImpulse[0] != 0.0f || c.tangentImpulse[1] != 0.0f) {
+		ApplyImpulse(c, c.normal * c.normalImpulse + c.tangents[0] * c.tangentImpulse[0] + c.tangents[1] * c.tangentImpulse[1]);
+	}
+}
+
+static void SolveConstraint(ContactConstraint& c)
+{
+	// Friction first, bounded by the normal impulse found so far
+	const float maxFriction = c.friction * c.normalImpulse;
+	for (int t = 0; t < 2; t++) {
+		const float tangentVelocity = RelativeVelocity(c).Dot(c.tangents[t]);
+		const float oldImpulse = c.tangentImpulse[t];
+		c.tangentImpulse[t] = std::max(-maxFriction, std::min(oldImpulse - tangentVelocity * c.tangentMass[t], maxFriction));
+		ApplyImpulse(c, c.tangents[t] * (c.tangentImpulse[t] - oldImpulse));
+	}
+
+	const float normalVelocity = RelativeVelocity(c).Dot(c.normal);
+	const float oldImpulse = c.normalImpulse;
+	c.normalImpulse = std::max(oldImpulse + (c.velocityBias - normalVelocity) * c.normalMass, 0.0f);
+	ApplyImpulse(c, c.normal * (c.normalImpulse - oldImpulse));
+}
+
+// Keeps the totals for the next warm start
+static void StoreConstraint(const ContactConstraint& c)
+{
+	c.point->normalImpulse = c.normalImpulse;
+	c.point->frictionImpulse = c.tangents[0] * c.tangentImpulse[0] + c.tangents[1] * c.tangentImpulse[1];
+
+	Body* bodies[2] = { c.a, c.b };
+	for (Body* body : bodies) {
+		if (body->inverseMass != 0.0f && body->angularVelocity.GetLengthSqr() > MAX_ANGULAR_SPEED * MAX_ANGULAR_SPEED) {
+			body->angularVelocity.Normalize();
+			body->angularVelocity *= MAX_ANGULAR_SPEED;
+		}
+	}
+}
+
+void ContactSolver::Solve(const Contact* contacts, ContactPoint* const* points, const int numContacts, const float dt_sec, ContactConstraint* constraints) const
+{
+	const float inverseDt = 1.0f / dt_sec;
+	for (int i = 0; i < numContacts; i++) {
+		PrepareConstraint(contacts[i], points[i], inverseDt, constraints[i]);
+		WarmStart(constraints[i]);
+	}
+	for (int iteration = 0; iteration < numIterations; iteration++) {
+		for (int i = 0; i < numContacts; i++) {
+			SolveConstraint(constraints[i]);
+		}
+	}
+	for (int i = 0; i < numContacts; i++) {
+		StoreConstraint(constraints[i]);
+	}
+}
+
+// Runs task over the contacts of a color, split over the threads when there
+// are enough of them. The contacts of a color share no dynamic body, so the
+// split does not change the result.
+template<typename Task>
+static void ForEachInColor(const int* order, const int first, const int last, const bool canSplit, const Task& task)
+{
+	JobSystem& jobs = JobSystem::Get();
+	const int count = last - first;
+	int numBlocks = std::min(jobs.GetNumThreads(), count / MIN_CONTACTS_PER_BLOCK);
+	if (!canSplit || numBlocks < 2) {
+		for (int i = first; i < last; i++) {
+			task(order[i]);
+		}
+		return;
+	}
+	const int blockSize = (count + numBlocks - 1) / numBlocks;
+	jobs.ParallelFor(numBlocks, [&](int block) {
+		const int blockFirst = first + block * blockSize;
+		const int blockLast = std::min(blockFirst + blockSize, last);
+		for (int i = blockFirst; i < blockLast; i++) {
+			task(order[i]);
+		}
+	});
+}
+
+int ContactSolver::SolveColored(const Contact* contacts, ContactPoint* const* points, const CollisionPair* bodyPairs, const int numContacts, const int numBodies, const float dt_sec, ContactConstraint* constraints, FrameArena& arena) const
+{
+	if (numContacts == 0) {
+		return 0;
+	}
+
+	// Greedy coloring, each contact takes the lowest color free on both of
+	// its bodies. A static body is never written, it does not take colors.
+	uint64_t* bodyColors = arena.Allocate<uint64_t>(numBodies);
+	memset(bodyColors, 0, sizeof(uint64_t) * numBodies);
+	int* contactColor = arena.Allocate<int>(numContacts);
+	int colorStart[MAX_COLORS + 2] = {};
+	int numColors = 0;
+	for (int i = 0; i < numContacts; i++) {
+		const int a = bodyPairs[i].a;
+		const int b = bodyPairs[i].b;
+		const bool isDynamicA = contacts[i].a->inverseMass != 0.0f;
+		const bool isDynamicB = contacts[i].b->inverseMass != 0.0f;
+		const uint64_t used = (isDynamicA ? bodyColors[a] : 0) | (isDynamicB ? bodyColors[b] : 0);
+		int color = OVERFLOW_COLOR;
+		if (used != ~0ULL) {
+			color = 0;
+			while (used & (1ULL << color)) {
+				++color;
+			}
+			if (isDynamicA) {
+				bodyColors[a] |= 1ULL << color;
+			}
+			if (isDynamicB) {
+				bodyColors[b] |= 1ULL << color;
+			}
+		}
+		contactColor[i] = color;
+		++colorStart[color + 1];
+		numColors = std::max(numColors, color + 1);
+	}
+	for (int color = 0; color <= MAX_COLORS; color++) {
+		colorStart[color + 1] += colorStart[color];
+	}
+	int* order = arena.Allocate<int>(numContacts);
+	int colorFill[MAX_COLORS + 1];
+	memcpy(colorFill, colorStart, sizeof(colorFill));
+	for (int i = 0; i < numContacts; i++) {
+		order[colorFill[contactColor[i]]++] = i;
+	}
+
+	// Color by color, the contacts that found no color go last on one thread
+	const auto forEachContact = [&](const auto& task) {
+		for (int color = 0; color < numColors; color++) {
+			ForEachInColor(order, colorStart[color], colorStart[color + 1], color != OVERFLOW_COLOR, task);
+		}
+	};
+
+	const float inverseDt = 1.0f / dt_sec;
+	forEachContact([&](const int i) {
+		PrepareConstraint(contacts[i], points[i], inverseDt, constraints[i]);
+		WarmStart(constraints[i]);
+	});
+	for (int iteration = 0; iteration < numIterations; iteration++) {
+		forEachContact([&](const int i) {
+			SolveConstraint(constraints[i]);
+		});
+	}
+	forEachContact([&](const int i) {
+		StoreConstraint(constraints[i]);
+	});
+	return numColors;
+}
+
+const char* ContactSolverTypeName(const ContactSolverType type)
+{
+	switch (type) {
+	case ContactSolverType::TIME_OF_IMPACT: return "toi";
+	case ContactSolverType::SEQUENTIAL_IMPULSE: return "si";
+	}
+	return "unknown";
+}
+
+bool ParseContactSolverType(const char* name, ContactSolverType& type)
+{
+	const ContactSolverType types[] = {
+		ContactSolverType::TIME_OF_IMPACT,
+		ContactSolverType::SEQUENTIAL_IMPULSE,
+	};
+	for (const ContactSolverType candidate : types) {
+		if (strcmp(name, ContactSolverTypeName(candidate)) == 0) {
+			type = candidate;
+			return true;
+		}
+	}
+	return false;
+}
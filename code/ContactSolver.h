@@ -0,0 +1,75 @@
+#pragma once
+#include "ContactCache.h"
+
+class FrameArena;
+
+enum class ContactSolverType
+{
+	TIME_OF_IMPACT,		// sub-steps to each time of impact and applies one impulse per contact
+	SEQUENTIAL_IMPULSE,	// iterates over all contacts of an island at the start of the step
+};
+
+const char* ContactSolverTypeName(const ContactSolverType type);
+bool ParseContactSolverType(const char* name, ContactSolverType& type);
+
+// One contact as the solver sees it, built at the start of Solve
+struct ContactConstraint
+{
+	Body* a;
+	Body* b;
+	Mat3 inverseInertiaA;
+	Mat3 inverseInertiaB;
+	Vec3 rA;
+	Vec3 rB;
+	Vec3 normal;		// from B to A
+	Vec3 tangents[2];
+	float normalMass;
+	float tangentMass[2];
+	float velocityBias;
+	float friction;
+	float normalImpulse;
+	float tangentImpulse[2];
+	ContactPoint* point;
+};
+
+// Sequential impulse solver. The normal and friction impulses of each
+// contact accumulate over the iterations and the totals are clamped
+// (pushing only, friction inside the friction box), so a pile settles
+// instead of bouncing between contacts solved one at a time.
+// Contacts not touching yet are speculative, they only stop the bodies
+// from closing more than the gap this step, which keeps fast balls from
+// tunnelling without sub-stepping to the time of impact.
+// The totals are written back to the cached contact points and applied
+// up front on the next step (warm starting), a resting contact then
+// starts close to its answer.
+class ContactSolver
+{
+public:
+	void SetNumIterations(const int iterations) { numIterations = iterations; }
+	int GetNumIterations() const { return numIterations; }
+
+	// Solves the contacts of one island, points holds the cached point of
+	// each contact (see ContactCache::AddContact) with the warm start.
+	// constraints is scratch for numContacts, taken from the frame arena
+	// before the islands start since the arena is not thread safe.
+	// Islands share no dynamic body and static bodies are only read, so
+	// several islands may be solved at once.
+	void Solve(const Contact* contacts, ContactPoint* const* points, const int numContacts, const float dt_sec, ContactConstraint* constraints) const;
+
+	// Same as Solve for one large island, with the contacts split into colors
+	// where no two contacts of a color share a dynamic body. The colors are
+	// solved one after the other and the contacts of a color are spread over
+	// the JobSystem. bodyPairs holds the scene indices of the bodies of each
+	// contact, in the order of contact.a and contact.b, numBodies bounds them.
+	// The result does not depend on the number of threads, it differs from
+	// Solve since the contacts are visited in another order. Takes scratch
+	// from the arena, call it from the thread running the step.
+	// Returns the number of colors, contacts past MAX_COLORS share the last one.
+	int SolveColored(const Contact* contacts, ContactPoint* const* points, const CollisionPair* bodyPairs, const int numContacts, const int numBodies, const float dt_sec, ContactConstraint* constraints, FrameArena& arena) const;
+
+	static const int MAX_COLORS = 64;
+	static const int OVERFLOW_COLOR = MAX_COLORS;
+
+private:
+	int numIterations = 8;
+};
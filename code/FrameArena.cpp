@@ -0,0 +1,76 @@
+#include "FrameArena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static size_t AlignUp(const size_t value, const size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::FrameArena(const size_t capacity) :
+buffer(nullptr),
+capacity(0),
+offset(0),
+overflowBytes(0),
+highWaterMark(0),
+numOverflows(0)
+{
+	Reserve(capacity);
+}
+
+FrameArena::~FrameArena()
+{
+	Reset();
+	free(buffer);
+}
+
+void FrameArena::Reserve(const size_t bytes)
+{
+	// Only grows between steps, the allocations handed out must stay put
+	if (bytes <= capacity || offset != 0 || !overflowBlocks.empty()) {
+		return;
+	}
+	free(buffer);
+	capacity = AlignUp(bytes, 4096);
+	buffer = (char*)malloc(capacity);
+}
+
+void FrameArena::Reset()
+{
+	const bool overflowed = !overflowBlocks.empty();
+	for (void* block : overflowBlocks) {
+		free(block);
+	}
+	overflowBlocks.clear();
+	overflowBytes = 0;
+	offset = 0;
+
+	if (overflowed) {
+		Reserve(highWaterMark);
+	}
+}
+
+void* FrameArena::Allocate(const size_t size, const size_t alignment)
+{
+	// The buffer comes from malloc, aligning the address rather than the
+	// offset keeps alignments above the malloc guarantee correct
+	const uintptr_t base = (uintptr_t)buffer;
+	const size_t start = (size_t)(AlignUp(base + offset, alignment) - base);
+	if (buffer != nullptr && start + size <= capacity) {
+		offset = start + size;
+		if (GetUsed() > highWaterMark) {
+			highWaterMark = GetUsed();
+		}
+		return buffer + start;
+	}
+
+	void* block = malloc(size + alignment);
+	overflowBlocks.push_back(block);
+	overflowBytes += size + alignment;
+	++numOverflows;
+	if (GetUsed() > highWaterMark) {
+		highWaterMark = GetUsed();
+	}
+	return (void*)AlignUp((uintptr_t)block, alignment);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that only lives for one physics step, such as
+// broadphase endpoints, contacts and solver scratch. Allocating bumps an
+// offset and Reset drops everything at once. When a step needs more than
+// the reserved capacity, the extra allocations go to overflow blocks from
+// the heap and the next Reset grows the buffer to the high-water mark, so
+// a scene settles on a single allocation after its busiest step.
+class FrameArena
+{
+public:
+	explicit FrameArena(const size_t capacity = 0);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void Reserve(const size_t bytes);
+	void Reset();
+
+	void* Allocate(const size_t size, const size_t alignment = 16);
+
+	// Objects are never destroyed, only types that need no destructor fit
+	template<typename T>
+	T* Allocate(const int count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+		if (count <= 0) {
+			return nullptr;
+		}
+		T* items = (T*)Allocate(sizeof(T) * count, alignof(T) > 16 ? alignof(T) : 16);
+		for (int i = 0; i < count; i++) {
+			new (&items[i]) T;
+		}
+		return items;
+	}
+
+	size_t GetUsed() const { return offset + overflowBytes; }
+	size_t GetCapacity() const { return capacity; }
+	size_t GetHighWaterMark() const { return highWaterMark; }
+	int GetNumOverflows() const { return numOverflows; }
+
+private:
+	char* buffer;
+	size_t capacity;
+	size_t offset;
+
+	std::vector<void*> overflowBlocks;
+	size_t overflowBytes;
+
+	size_t highWaterMark;
+	int numOverflows;
+};
@@ -0,0 +1,102 @@
+//
+//  HeadlessMain.cpp
+//
+#include "SceneBuilder.h"
+#include "../Scene.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+====================================================
+PrintUsage
+====================================================
+*/
+static void PrintUsage( const char * exe ) {
+	printf( "usage: %s [--bodies N] [--layout dense|sparse|ground] [--broadphase sap1d|sap|tree|grid] [--solver toi|si] [--steps N] [--substeps N] [--dt seconds] [--seed N] [--frame-kb N]\n", exe );
+}
+
+/*
+====================================================
+main
+Steps a generated scene as fast as the CPU allows, the same
+way Application::MainLoop does but without GLFW or Vulkan
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	int numBodies = 1000;
+	int numSteps = 600;
+	int numSubSteps = 1;
+	float dt_sec = 1.0f / 60.0f;
+	unsigned int seed = 1;
+	int frameKiloBytes = 0;
+	SceneLayout layout = SceneLayout::Sparse;
+	BroadPhaseType broadPhaseType = BroadPhaseType::SWEEP_AND_PRUNE;
+	ContactSolverType solverType = ContactSolverType::SEQUENTIAL_IMPULSE;
+
+	for ( int i = 1; i < argc; i++ ) {
+		const bool hasValue = ( i + 1 < argc );
+		if ( 0 == strcmp( argv[ i ], "--bodies" ) && hasValue ) {
+			numBodies = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--steps" ) && hasValue ) {
+			numSteps = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--substeps" ) && hasValue ) {
+			numSubSteps = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--dt" ) && hasValue ) {
+			dt_sec = (float)atof( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--seed" ) && hasValue ) {
+			seed = (unsigned int)atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--frame-kb" ) && hasValue ) {
+			frameKiloBytes = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--layout" ) && hasValue && ParseSceneLayout( argv[ i + 1 ], layout ) ) {
+			i++;
+		} else if ( 0 == strcmp( argv[ i ], "--broadphase" ) && hasValue && ParseBroadPhaseType( argv[ i + 1 ], broadPhaseType ) ) {
+			i++;
+		} else if ( 0 == strcmp( argv[ i ], "--solver" ) && hasValue && ParseContactSolverType( argv[ i + 1 ], solverType ) ) {
+			i++;
+		} else {
+			PrintUsage( argv[ 0 ] );
+			return 1;
+		}
+	}
+	if ( numBodies < 0 || numSteps <= 0 || numSubSteps <= 0 ) {
+		PrintUsage( argv[ 0 ] );
+		return 1;
+	}
+
+	Scene * scene = new Scene;
+	scene->SetBroadPhaseType( broadPhaseType );
+	scene->SetContactSolverType( solverType );
+	scene->ReserveFrameMemory( (size_t)frameKiloBytes * 1024 );
+	scene->Initialize();
+	AddGeneratedSpheres( *scene, numBodies, layout, seed );
+
+	const auto start = std::chrono::steady_clock::now();
+	for ( int step = 0; step < numSteps; step++ ) {
+		for ( int i = 0; i < numSubSteps; i++ ) {
+			scene->Update( dt_sec / (float)numSubSteps );
+		}
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const double seconds = std::chrono::duration< double >( end - start ).count();
+	const double stepsPerSecond = (double)numSteps / seconds;
+	printf( "bodies: %d (%s, %s, %s)  steps: %d x %d substeps  time: %.3f s\n", numBodies, SceneLayoutName( layout ), BroadPhaseTypeName( broadPhaseType ), ContactSolverTypeName( solverType ), numSteps, numSubSteps, seconds );
+	printf( "steps/sec: %.1f  body-steps/sec: %.0f\n", stepsPerSecond, stepsPerSecond * (double)scene->GetBodies().size() );
+
+	// Pass the high-water mark back through --frame-kb to avoid the overflow allocations
+	const FrameArena & frameArena = scene->GetFrameArena();
+	printf( "frame arena: %.1f KB high-water, %.1f KB reserved, %d overflow allocations\n",
+		(double)frameArena.GetHighWaterMark() / 1024.0, (double)frameArena.GetCapacity() / 1024.0, frameArena.GetNumOverflows() );
+
+	printf( "awake bodies: %d of %d last step\n", scene->lastStepStats.numAwakeBodies, numBodies );
+	const ContactCache & contactCache = scene->GetContactCache();
+	printf( "contact cache: %d manifolds, %d of %d contacts warm started last step\n",
+		contactCache.GetNumManifolds(), scene->lastStepStats.numCachedContacts, scene->lastStepStats.numContacts );
+	printf( "pools: %d bodies live, %d shapes shared by %d bodies, %d blocks\n", scene->GetNumLiveBodies(), scene->GetShapes().GetNumShapes(), scene->GetShapes().GetNumReferences(), scene->GetPoolCapacity() );
+
+	delete scene;
+	return 0;
+}
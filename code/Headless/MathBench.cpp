@@ -0,0 +1,378 @@
+//
+//  MathBench.cpp
+//
+#include "../Math/Vector.h"
+#include "../Math/Matrix.h"
+#include "../Math/Quat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/*
+====================================================
+Scalar references
+The scalar code of the math types written out on plain floats,
+so that they hold whichever backend the types are built with
+====================================================
+*/
+struct RefVec3 {
+	float x, y, z;
+};
+
+struct RefQuat {
+	float w, x, y, z;
+};
+
+struct RefMat3 {
+	float m[ 3 ][ 3 ];
+};
+
+static RefVec3 RefCross( const RefVec3 & a, const RefVec3 & b ) {
+	RefVec3 r;
+	r.x = ( a.y * b.z ) - ( b.y * a.z );
+	r.y = ( b.x * a.z ) - ( a.x * b.z );
+	r.z = ( a.x * b.y ) - ( b.x * a.y );
+	return r;
+}
+
+static float RefDot( const RefVec3 & a, const RefVec3 & b ) {
+	return ( a.x * b.x ) + ( a.y * b.y ) + ( a.z * b.z );
+}
+
+static RefQuat RefMul( const RefQuat & a, const RefQuat & b ) {
+	RefQuat r;
+	r.w = ( a.w * b.w ) - ( a.x * b.x ) - ( a.y * b.y ) - ( a.z * b.z );
+	r.x = ( a.x * b.w ) + ( a.w * b.x ) + ( a.y * b.z ) - ( a.z * b.y );
+	r.y = ( a.y * b.w ) + ( a.w * b.y ) + ( a.z * b.x ) - ( a.x * b.z );
+	r.z = ( a.z * b.w ) + ( a.w * b.z ) + ( a.x * b.y ) - ( a.y * b.x );
+	return r;
+}
+
+static RefVec3 RefRotate( const RefQuat & q, const RefVec3 & v ) {
+	const float invMagSqr = 1.0f / ( q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w );
+	const RefQuat inverse = { q.w * invMagSqr, -q.x * invMagSqr, -q.y * invMagSqr, -q.z * invMagSqr };
+	const RefQuat vector = { 0.0f, v.x, v.y, v.z };
+	const RefQuat r = RefMul( RefMul( q, vector ), inverse );
+	return RefVec3{ r.x, r.y, r.z };
+}
+
+static RefMat3 RefMul( const RefMat3 & a, const RefMat3 & b ) {
+	RefMat3 r;
+	for ( int i = 0; i < 3; i++ ) {
+		for ( int j = 0; j < 3; j++ ) {
+			r.m[ i ][ j ] = a.m[ i ][ 0 ] * b.m[ 0 ][ j ] + a.m[ i ][ 1 ] * b.m[ 1 ][ j ] + a.m[ i ][ 2 ] * b.m[ 2 ][ j ];
+		}
+	}
+	return r;
+}
+
+static RefVec3 RefMul( const RefMat3 & a, const RefVec3 & v ) {
+	RefVec3 r;
+	r.x = a.m[ 0 ][ 0 ] * v.x + a.m[ 0 ][ 1 ] * v.y + a.m[ 0 ][ 2 ] * v.z;
+	r.y = a.m[ 1 ][ 0 ] * v.x + a.m[ 1 ][ 1 ] * v.y + a.m[ 1 ][ 2 ] * v.z;
+	r.z = a.m[ 2 ][ 0 ] * v.x + a.m[ 2 ][ 1 ] * v.y + a.m[ 2 ][ 2 ] * v.z;
+	return r;
+}
+
+// Mat3::Inverse as it used to be, through the Mat2 minors
+static Mat3 CofactorInverse( const Mat3 & m ) {
+	Mat3 inv;
+	for ( int i = 0; i < 3; i++ ) {
+		for ( int j = 0; j < 3; j++ ) {
+			inv.rows[ j ][ i ] = m.Cofactor( i, j );
+		}
+	}
+	inv *= 1.0f / m.Determinant();
+	return inv;
+}
+
+static Vec3 ToVec3( const RefVec3 & v ) { return Vec3( v.x, v.y, v.z ); }
+static Quat ToQuat( const RefQuat & q ) { return Quat( q.x, q.y, q.z, q.w ); }
+static Mat3 ToMat3( const RefMat3 & a ) {
+	return Mat3( Vec3( a.m[ 0 ][ 0 ], a.m[ 0 ][ 1 ], a.m[ 0 ][ 2 ] ), Vec3( a.m[ 1 ][ 0 ], a.m[ 1 ][ 1 ], a.m[ 1 ][ 2 ] ), Vec3( a.m[ 2 ][ 0 ], a.m[ 2 ][ 1 ], a.m[ 2 ][ 2 ] ) );
+}
+
+/*
+====================================================
+Inputs
+====================================================
+*/
+struct Inputs {
+	std::vector< RefVec3 > vecs;
+	std::vector< RefQuat > quats;
+	std::vector< RefMat3 > mats;
+
+	// Well conditioned matrices for the inverses: diagonally dominant,
+	// symmetric positive definite like an inertia tensor, and diagonal
+	std::vector< Mat3 > invertible;
+	std::vector< Mat3 > symmetric;
+	std::vector< Mat3 > diagonal;
+};
+
+static Inputs MakeInputs( const int num, const unsigned seed ) {
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution< float > unit( -1.0f, 1.0f );
+	Inputs inputs;
+	inputs.vecs.resize( num );
+	inputs.quats.resize( num );
+	inputs.mats.resize( num );
+	for ( int i = 0; i < num; i++ ) {
+		inputs.vecs[ i ] = RefVec3{ unit( rng ) * 10.0f, unit( rng ) * 10.0f, unit( rng ) * 10.0f };
+		// Rotations as the bodies hold them, near unit length
+		RefQuat q = { unit( rng ), unit( rng ), unit( rng ), unit( rng ) };
+		const float invMag = 1.0f / sqrtf( q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z );
+		inputs.quats[ i ] = RefQuat{ q.w * invMag, q.x * invMag, q.y * invMag, q.z * invMag };
+		for ( int r = 0; r < 3; r++ ) {
+			for ( int c = 0; c < 3; c++ ) {
+				inputs.mats[ i ].m[ r ][ c ] = unit( rng ) * 4.0f;
+			}
+		}
+	}
+
+	inputs.invertible.resize( num );
+	inputs.symmetric.resize( num );
+	inputs.diagonal.resize( num );
+	for ( int i = 0; i < num; i++ ) {
+		Mat3 identity;
+		identity.Identity();
+		const Mat3 m = ToMat3( inputs.mats[ i ] );
+		inputs.invertible[ i ] = m + identity * ( unit( rng ) < 0.0f ? -12.0f : 12.0f );
+		inputs.symmetric[ i ] = m * m.Transpose() * ( 1.0f / 16.0f ) + identity;
+		inputs.diagonal[ i ].Zero();
+		for ( int d = 0; d < 3; d++ ) {
+			inputs.diagonal[ i ].rows[ d ][ d ] = 0.1f + fabsf( inputs.mats[ i ].m[ d ][ d ] );
+		}
+	}
+	return inputs;
+}
+
+/*
+====================================================
+CrossCheck
+Largest difference between the types and the scalar references,
+relative to the size of the result
+====================================================
+*/
+struct CheckResult {
+	const char * name;
+	float maxError;
+};
+
+static float RelativeError( const float * a, const float * b, const int num ) {
+	float error = 0.0f;
+	float size = 1.0f;
+	for ( int i = 0; i < num; i++ ) {
+		error = std::max( error, fabsf( a[ i ] - b[ i ] ) );
+		size = std::max( size, fabsf( b[ i ] ) );
+	}
+	return error / size;
+}
+
+static float MatrixError( const Mat3 & a, const Mat3 & b ) {
+	float error = 0.0f;
+	for ( int r = 0; r < 3; r++ ) {
+		const Vec3 rowA = a.rows[ r ];
+		const Vec3 rowB = b.rows[ r ];
+		error = std::max( error, RelativeError( &rowA.x, &rowB.x, 3 ) );
+	}
+	return error;
+}
+
+static std::vector< CheckResult > CrossCheck( const Inputs & inputs ) {
+	CheckResult cross = { "cross", 0.0f };
+	CheckResult dot = { "dot", 0.0f };
+	CheckResult crossA = { "cross_vec3a", 0.0f };
+	CheckResult dotA = { "dot_vec3a", 0.0f };
+	CheckResult quatMul = { "quat_mul", 0.0f };
+	CheckResult rotate = { "rotate_point", 0.0f };
+	CheckResult matMul = { "mat3_mul", 0.0f };
+	CheckResult matVec = { "mat3_mul_vec", 0.0f };
+	CheckResult vec4 = { "vec4_dot", 0.0f };
+	CheckResult inverse = { "inverse", 0.0f };
+	CheckResult inverseSym = { "inverse_sym", 0.0f };
+	CheckResult inverseDiag = { "inverse_diag", 0.0f };
+	CheckResult residual = { "inverse_resid", 0.0f };
+	Mat3 identity;
+	identity.Identity();
+	const int num = (int)inputs.vecs.size();
+	for ( int i = 0; i < num; i++ ) {
+		const RefVec3 & a = inputs.vecs[ i ];
+		const RefVec3 & b = inputs.vecs[ ( i + 1 ) % num ];
+		const RefQuat & q = inputs.quats[ i ];
+		const RefQuat & p = inputs.quats[ ( i + 1 ) % num ];
+		const RefMat3 & m = inputs.mats[ i ];
+		const RefMat3 & n = inputs.mats[ ( i + 1 ) % num ];
+
+		const RefVec3 refCross = RefCross( a, b );
+		const float refDot = RefDot( a, b );
+		const Vec3 gotCross = ToVec3( a ).Cross( ToVec3( b ) );
+		const float gotDot = ToVec3( a ).Dot( ToVec3( b ) );
+		cross.maxError = std::max( cross.maxError, RelativeError( &gotCross.x, &refCross.x, 3 ) );
+		dot.maxError = std::max( dot.maxError, RelativeError( &gotDot, &refDot, 1 ) );
+
+		const Vec3A gotCrossA = Vec3A( ToVec3( a ) ).Cross( Vec3A( ToVec3( b ) ) );
+		const float gotDotA = Vec3A( ToVec3( a ) ).Dot( Vec3A( ToVec3( b ) ) );
+		crossA.maxError = std::max( crossA.maxError, RelativeError( &gotCrossA.x, &refCross.x, 3 ) );
+		dotA.maxError = std::max( dotA.maxError, RelativeError( &gotDotA, &refDot, 1 ) );
+
+		const RefQuat refQuat = RefMul( q, p );
+		const Quat gotQuat = ToQuat( q ) * ToQuat( p );
+		quatMul.maxError = std::max( quatMul.maxError, RelativeError( &gotQuat.w, &refQuat.w, 4 ) );
+
+		const RefVec3 refRotate = RefRotate( q, a );
+		const Vec3 gotRotate = ToQuat( q ).RotatePoint( ToVec3( a ) );
+		rotate.maxError = std::max( rotate.maxError, RelativeError( &gotRotate.x, &refRotate.x, 3 ) );
+
+		const RefMat3 refMat = RefMul( m, n );
+		const Mat3 gotMat = ToMat3( m ) * ToMat3( n );
+		for ( int r = 0; r < 3; r++ ) {
+			const Vec3 row = gotMat.rows[ r ];
+			matMul.maxError = std::max( matMul.maxError, RelativeError( &row.x, refMat.m[ r ], 3 ) );
+		}
+
+		const RefVec3 refMatVec = RefMul( m, a );
+		const Vec3 gotMatVec = ToMat3( m ) * ToVec3( a );
+		matVec.maxError = std::max( matVec.maxError, RelativeError( &gotMatVec.x, &refMatVec.x, 3 ) );
+
+		const float refVec4 = q.w * p.w + q.x * p.x + q.y * p.y + q.z * p.z;
+		const float gotVec4 = Vec4( q.w, q.x, q.y, q.z ).Dot( Vec4( p.w, p.x, p.y, p.z ) );
+		vec4.maxError = std::max( vec4.maxError, RelativeError( &gotVec4, &refVec4, 1 ) );
+
+		// Against the cofactor path, and M * M^-1 against the identity
+		const Mat3 & general = inputs.invertible[ i ];
+		const Mat3 & symmetric = inputs.symmetric[ i ];
+		const Mat3 & diagonal = inputs.diagonal[ i ];
+		const Mat3 gotInverse = general.Inverse();
+		const Mat3 gotInverseSym = symmetric.InverseSymmetric();
+		const Mat3 gotInverseDiag = diagonal.InverseDiagonal();
+		inverse.maxError = std::max( inverse.maxError, MatrixError( gotInverse, CofactorInverse( general ) ) );
+		inverseSym.maxError = std::max( inverseSym.maxError, MatrixError( gotInverseSym, CofactorInverse( symmetric ) ) );
+		inverseDiag.maxError = std::max( inverseDiag.maxError, MatrixError( gotInverseDiag, CofactorInverse( diagonal ) ) );
+		residual.maxError = std::max( residual.maxError, MatrixError( general * gotInverse, identity ) );
+		residual.maxError = std::max( residual.maxError, MatrixError( symmetric * gotInverseSym, identity ) );
+		residual.maxError = std::max( residual.maxError, MatrixError( diagonal * gotInverseDiag, identity ) );
+	}
+	return { cross, dot, crossA, dotA, quatMul, rotate, matMul, matVec, vec4, inverse, inverseSym, inverseDiag, residual };
+}
+
+/*
+====================================================
+Timing
+Each op of the math types runs over the whole input set until
+minTime has passed, the results are summed so that the work
+cannot be optimized out
+====================================================
+*/
+static volatile float gSink;
+
+// Every component feeds the sum, or the unused ones could be skipped
+static float Sum( const Vec3 & v ) { return v.x + v.y + v.z; }
+static float Sum( const Quat & q ) { return q.w + q.x + q.y + q.z; }
+static float Sum( const Mat3 & m ) { return Sum( Vec3( m.rows[ 0 ] ) ) + Sum( Vec3( m.rows[ 1 ] ) ) + Sum( Vec3( m.rows[ 2 ] ) ); }
+
+template< typename Op >
+static double NanosecondsPerOp( const int num, const double minTime, const Op & op ) {
+	long long numOps = 0;
+	float sum = 0.0f;
+	const auto start = std::chrono::steady_clock::now();
+	double seconds = 0.0;
+	do {
+		for ( int i = 0; i < num; i++ ) {
+			sum += op( i );
+		}
+		numOps += num;
+		seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+	} while ( seconds < minTime );
+	gSink = sum;
+	return seconds * 1e9 / (double)numOps;
+}
+
+struct TimeResult {
+	const char * name;
+	double ns;
+};
+
+static std::vector< TimeResult > TimeOps( const Inputs & inputs, const double minTime ) {
+	const int num = (int)inputs.vecs.size();
+	std::vector< Vec3 > vecs( num );
+	std::vector< Vec3A > vecsA( num );
+	std::vector< Quat > quats( num );
+	std::vector< Mat3 > mats( num );
+	for ( int i = 0; i < num; i++ ) {
+		vecs[ i ] = ToVec3( inputs.vecs[ i ] );
+		vecsA[ i ] = vecs[ i ];
+		quats[ i ] = ToQuat( inputs.quats[ i ] );
+		mats[ i ] = ToMat3( inputs.mats[ i ] );
+	}
+	const int mask = num - 1;
+
+	std::vector< TimeResult > results;
+	results.push_back( { "cross", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( vecsA[ i ].Cross( vecsA[ ( i + 1 ) & mask ] ) ); } ) } );
+	results.push_back( { "dot", NanosecondsPerOp( num, minTime, [&]( int i ) { return vecsA[ i ].Dot( vecsA[ ( i + 1 ) & mask ] ); } ) } );
+	results.push_back( { "rotate_point", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( quats[ i ].RotatePoint( vecs[ i ] ) ); } ) } );
+	results.push_back( { "quat_mul", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( quats[ i ] * quats[ ( i + 1 ) & mask ] ); } ) } );
+	results.push_back( { "mat3_mul", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( mats[ i ] * mats[ ( i + 1 ) & mask ] ); } ) } );
+	results.push_back( { "mat3_mul_vec", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( mats[ i ] * vecs[ i ] ); } ) } );
+
+	// The inverses next to the cofactor path they replace, in the same build
+	const Mat3 * invertible = inputs.invertible.data();
+	const Mat3 * symmetric = inputs.symmetric.data();
+	const Mat3 * diagonal = inputs.diagonal.data();
+	results.push_back( { "inverse_cofac", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( CofactorInverse( invertible[ i ] ) ); } ) } );
+	results.push_back( { "inverse", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( invertible[ i ].Inverse() ); } ) } );
+	results.push_back( { "inverse_sym", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( symmetric[ i ].InverseSymmetric() ); } ) } );
+	results.push_back( { "inverse_diag", NanosecondsPerOp( num, minTime, [&]( int i ) { return Sum( diagonal[ i ].InverseDiagonal() ); } ) } );
+	return results;
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	double minTime = 0.25;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( 0 == strcmp( argv[ i ], "--min-time" ) && i + 1 < argc ) {
+			minTime = atof( argv[ ++i ] );
+		} else {
+			printf( "usage: %s [--min-time seconds]\n", argv[ 0 ] );
+			return 1;
+		}
+	}
+
+#if defined( MATH_SIMD ) && defined( __AVX__ )
+	printf( "math backend: simd (avx)\n" );
+#elif defined( MATH_SIMD )
+	printf( "math backend: simd (sse4.1)\n" );
+#else
+	printf( "math backend: scalar\n" );
+#endif
+
+	// Rounding may differ from the scalar order of operations, not more
+	const float tolerance = 1e-5f;
+	const Inputs inputs = MakeInputs( 4096, 1234 );
+	bool passed = true;
+	for ( const CheckResult & check : CrossCheck( inputs ) ) {
+		const bool ok = check.maxError <= tolerance;
+		printf( "check %-14s max relative error %.3g %s\n", check.name, check.maxError, ok ? "ok" : "FAILED" );
+		passed = passed && ok;
+	}
+
+	// Compare against the same numbers from a build with the other backend
+	for ( const TimeResult & time : TimeOps( inputs, minTime ) ) {
+		printf( "%-14s %6.2f ns/op\n", time.name, time.ns );
+	}
+
+	if ( !passed ) {
+		printf( "ERROR: the math types differ from the scalar references\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,538 @@
+//
+//  PhysicsBench.cpp
+//
+#include "SceneBuilder.h"
+#include "../Scene.h"
+#include "../Broadphase.h"
+#include "../SweepAndPrune.h"
+#include "../Narrowphase.h"
+#include "../Contact.h"
+#include "../ContactSolver.h"
+#include "../FrameArena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/*
+====================================================
+BenchResult
+====================================================
+*/
+struct BenchResult {
+	std::string name;
+	int numBodies;
+	SceneLayout layout;
+	int iterations;
+	double seconds;
+	long long pairs;	// summed over all iterations
+	long long contacts;	// summed over all iterations
+	long long falsePositives;	// broadphase pairs whose 3D bounds do not overlap, summed
+	long long rejectedPairs;	// candidates the broadphase dropped with its 3D test, summed
+	long long bodyUpdates;		// Body::Update calls made by Scene::Update, summed
+};
+
+struct BenchOptions {
+	int maxBodies = 10000;
+	double minTime = 0.25;
+	const char * filter = nullptr;
+	const char * jsonPath = nullptr;
+};
+
+static const float gDt = 1.0f / 120.0f;	// one of the two substeps of MainLoop
+
+/*
+====================================================
+BenchClock
+====================================================
+*/
+class BenchClock {
+public:
+	BenchClock() : start( std::chrono::steady_clock::now() ) {}
+	double Seconds() const { return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count(); }
+
+private:
+	std::chrono::steady_clock::time_point start;
+};
+
+/*
+====================================================
+BuildScene
+====================================================
+*/
+static Scene * BuildScene( const int numBodies, const SceneLayout layout ) {
+	Scene * scene = new Scene;
+	scene->Initialize();
+	AddGeneratedSpheres( *scene, numBodies, layout );
+	return scene;
+}
+
+/*
+====================================================
+FindContacts
+====================================================
+*/
+static int FindContacts( Scene & scene, const std::vector< CollisionPair > & pairs, std::vector< Contact > & contacts, const bool useBatches = true ) {
+	std::vector< int > contactPairs( pairs.size() );
+	contacts.resize( pairs.size() );
+	const int numContacts = NarrowPhase( scene.GetBodies(), pairs, gDt, contacts.data(), contactPairs.data(), useBatches );
+	contacts.resize( numContacts );
+	return numContacts;
+}
+
+/*
+====================================================
+CountBatchMismatches
+Contacts from the SIMD sphere batches that differ from the one
+pair at a time path, both run in pair order so they line up
+====================================================
+*/
+static int CountBatchMismatches( Scene & scene, const std::vector< CollisionPair > & pairs ) {
+	std::vector< Contact > scalar;
+	std::vector< Contact > batched;
+	FindContacts( scene, pairs, scalar, false );
+	FindContacts( scene, pairs, batched, true );
+	if ( scalar.size() != batched.size() ) {
+		return abs( (int)scalar.size() - (int)batched.size() );
+	}
+
+	const float tolerance = 1e-4f;
+	int numMismatches = 0;
+	for ( int i = 0; i < scalar.size(); i++ ) {
+		const Contact & a = scalar[ i ];
+		const Contact & b = batched[ i ];
+		if ( a.a != b.a || a.b != b.b
+			|| fabsf( a.timeOfImpact - b.timeOfImpact ) > tolerance
+			|| ( a.ptOnAWorldSpace - b.ptOnAWorldSpace ).GetMagnitude() > tolerance
+			|| ( a.ptOnBWorldSpace - b.ptOnBWorldSpace ).GetMagnitude() > tolerance
+			|| ( a.ptOnALocalSpace - b.ptOnALocalSpace ).GetMagnitude() > tolerance
+			|| ( a.ptOnBLocalSpace - b.ptOnBLocalSpace ).GetMagnitude() > tolerance ) {
+			numMismatches++;
+		}
+	}
+	return numMismatches;
+}
+
+/*
+====================================================
+BenchBroadPhase
+====================================================
+*/
+static BenchResult BenchBroadPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	Scene * scene = BuildScene( numBodies, layout );
+	BenchResult result = { "broadphase", numBodies, layout, 0, 0.0, 0, 0, 0, 0, 0 };
+
+	std::vector< CollisionPair > pairs;
+	PairFilterStats filterStats;
+	BenchClock clock;
+	do {
+		BroadPhase( scene->GetBodies(), pairs, gDt, &filterStats );
+		result.pairs += (long long)pairs.size();
+		result.rejectedPairs += filterStats.numRejectedPairs;
+		result.iterations++;
+	} while ( clock.Seconds() < options.minTime );
+	result.seconds = clock.Seconds();
+
+	delete scene;
+	return result;
+}
+
+/*
+====================================================
+CountFalsePairs
+====================================================
+*/
+static int CountFalsePairs( const Scene & scene, const std::vector< CollisionPair > & pairs ) {
+	int numFalsePairs = 0;
+	for ( int i = 0; i < pairs.size(); i++ ) {
+		const Bounds boundsA = GetSweptBounds( *scene.GetBodies()[ pairs[ i ].a ], gDt );
+		const Bounds boundsB = GetSweptBounds( *scene.GetBodies()[ pairs[ i ].b ], gDt );
+		if ( !boundsA.DoesIntersect( boundsB ) ) {
+			numFalsePairs++;
+		}
+	}
+	return numFalsePairs;
+}
+
+/*
+====================================================
+RunPersistentBroadPhase
+The bodies drift along their velocity between iterations, outside
+of the timed region, so the persistent backends have work to do
+====================================================
+*/
+static BenchResult RunPersistentBroadPhase( const char * name, BroadPhaseBackend * backend, const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	Scene * scene = BuildScene( numBodies, layout );
+	BenchResult result = { name, numBodies, layout, 0, 0.0, 0, 0, 0, 0, 0 };
+
+	std::vector< CollisionPair > pairs;
+	BroadPhase( *backend, scene->GetBodies(), pairs, gDt );
+
+	BenchClock clock;
+	do {
+		for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+			Body & body = *scene->GetBodies()[ i ];
+			body.position += body.linearVelocity * gDt;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		BroadPhase( *backend, scene->GetBodies(), pairs, gDt );
+		result.seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+		result.pairs += (long long)pairs.size();
+		result.falsePositives += CountFalsePairs( *scene, pairs );
+		if ( backend->GetType() == BroadPhaseType::SWEEP_AND_PRUNE ) {
+			result.rejectedPairs += static_cast< SweepAndPrune * >( backend )->GetStats().numFalsePositives;
+		}
+		result.iterations++;
+	} while ( clock.Seconds() < options.minTime );
+
+	delete backend;
+	delete scene;
+	return result;
+}
+
+static BenchResult BenchIncrementalBroadPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunPersistentBroadPhase( "broadphase_incremental", new SweepAndPrune(), numBodies, layout, options );
+}
+
+static BenchResult BenchAdaptiveBroadPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunPersistentBroadPhase( "broadphase_adaptive", CreateBroadPhase( BroadPhaseType::SWEEP_AND_PRUNE ), numBodies, layout, options );
+}
+
+static BenchResult BenchTreeBroadPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunPersistentBroadPhase( "broadphase_tree", CreateBroadPhase( BroadPhaseType::AABB_TREE ), numBodies, layout, options );
+}
+
+static BenchResult BenchGridBroadPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunPersistentBroadPhase( "broadphase_grid", CreateBroadPhase( BroadPhaseType::HASH_GRID ), numBodies, layout, options );
+}
+
+/*
+====================================================
+RunNarrowPhase
+The batched run first checks its contacts against the scalar path
+====================================================
+*/
+static BenchResult RunNarrowPhase( const char * name, const bool useBatches, const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	Scene * scene = BuildScene( numBodies, layout );
+	BenchResult result = { name, numBodies, layout, 0, 0.0, 0, 0, 0, 0, 0 };
+
+	std::vector< CollisionPair > pairs;
+	BroadPhase( scene->GetBodies(), pairs, gDt );
+
+	if ( useBatches ) {
+		const int numMismatches = CountBatchMismatches( *scene, pairs );
+		if ( numMismatches > 0 ) {
+			printf( "ERROR: %d batched sphere contacts differ from the scalar path\n", numMismatches );
+		}
+	}
+
+	std::vector< Contact > contacts;
+	contacts.reserve( pairs.size() );
+	BenchClock clock;
+	do {
+		result.contacts += FindContacts( *scene, pairs, contacts, useBatches );
+		result.pairs += (long long)pairs.size();
+		result.iterations++;
+	} while ( clock.Seconds() < options.minTime );
+	result.seconds = clock.Seconds();
+
+	delete scene;
+	return result;
+}
+
+static BenchResult BenchNarrowPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunNarrowPhase( "narrowphase", true, numBodies, layout, options );
+}
+
+static BenchResult BenchScalarNarrowPhase( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunNarrowPhase( "narrowphase_scalar", false, numBodies, layout, options );
+}
+
+/*
+====================================================
+BenchResolveContacts
+The bodies are restored between iterations so every pass
+resolves the same contacts, only the resolve loop is timed
+====================================================
+*/
+static BenchResult BenchResolveContacts( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	Scene * scene = BuildScene( numBodies, layout );
+	BenchResult result = { "resolve", numBodies, layout, 0, 0.0, 0, 0, 0, 0, 0 };
+
+	std::vector< CollisionPair > pairs;
+	BroadPhase( scene->GetBodies(), pairs, gDt );
+	std::vector< Contact > contacts;
+	FindContacts( *scene, pairs, contacts );
+
+	std::vector< Body > snapshot;
+	snapshot.reserve( scene->GetBodies().size() );
+	for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+		snapshot.push_back( *scene->GetBodies()[ i ] );
+	}
+
+	BenchClock clock;
+	do {
+		const auto start = std::chrono::steady_clock::now();
+		for ( int i = 0; i < contacts.size(); i++ ) {
+			Contact::ResolveContact( contacts[ i ] );
+		}
+		result.seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+		result.contacts += (long long)contacts.size();
+		result.iterations++;
+
+		for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+			*scene->GetBodies()[ i ] = snapshot[ i ];
+		}
+	} while ( clock.Seconds() < options.minTime );
+
+	delete scene;
+	return result;
+}
+
+/*
+====================================================
+RunContactSolve
+The sequential impulse solver over the contacts of the first
+step, either in contact order on one thread or color by color
+with the colors spread over the JobSystem. Bodies and impulses
+are restored between iterations so every pass starts cold,
+compare with resolve for a single ResolveContact per contact
+====================================================
+*/
+static BenchResult RunContactSolve( const char * name, const bool colored, const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	Scene * scene = BuildScene( numBodies, layout );
+	BenchResult result = { name, numBodies, layout, 0, 0.0, 0, 0, 0, 0, 0 };
+
+	std::vector< CollisionPair > pairs;
+	BroadPhase( scene->GetBodies(), pairs, gDt );
+	std::vector< Contact > contacts( pairs.size() );
+	std::vector< int > contactPairs( pairs.size() );
+	const int numContacts = NarrowPhase( scene->GetBodies(), pairs, gDt, contacts.data(), contactPairs.data() );
+
+	// The cache turns each contact so that A is the lower body index
+	ContactCache cache;
+	std::vector< ContactPoint * > points( numContacts );
+	std::vector< CollisionPair > bodyPairs( numContacts );
+	for ( int i = 0; i < numContacts; i++ ) {
+		const CollisionPair & pair = pairs[ contactPairs[ i ] ];
+		points[ i ] = &cache.AddContact( scene->GetBodies(), scene->GetBodyStorage(), pair, contacts[ i ] );
+		bodyPairs[ i ].a = std::min( pair.a, pair.b );
+		bodyPairs[ i ].b = std::max( pair.a, pair.b );
+	}
+
+	std::vector< Body > snapshot;
+	snapshot.reserve( scene->GetBodies().size() );
+	for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+		snapshot.push_back( *scene->GetBodies()[ i ] );
+	}
+
+	ContactSolver solver;
+	std::vector< ContactConstraint > constraints( numContacts );
+	FrameArena arena( scene->GetBodies().size() * sizeof( uint64_t ) + numContacts * 2 * sizeof( int ) + 4096 );
+	BenchClock clock;
+	do {
+		const auto start = std::chrono::steady_clock::now();
+		if ( colored ) {
+			solver.SolveColored( contacts.data(), points.data(), bodyPairs.data(), numContacts, (int)scene->GetBodies().size(), gDt, constraints.data(), arena );
+		} else {
+			solver.Solve( contacts.data(), points.data(), numContacts, gDt, constraints.data() );
+		}
+		result.seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+		result.contacts += numContacts;
+		result.iterations++;
+
+		arena.Reset();
+		for ( int i = 0; i < numContacts; i++ ) {
+			points[ i ]->normalImpulse = 0.0f;
+			points[ i ]->frictionImpulse.Zero();
+		}
+		for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+			*scene->GetBodies()[ i ] = snapshot[ i ];
+		}
+	} while ( clock.Seconds() < options.minTime );
+
+	delete scene;
+	return result;
+}
+
+static BenchResult BenchSolveContacts( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunContactSolve( "solve", false, numBodies, layout, options );
+}
+
+static BenchResult BenchSolveColoredContacts( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunContactSolve( "solve_colored", true, numBodies, layout, options );
+}
+
+/*
+====================================================
+RunSceneUpdate
+Full steps with the impulse solver, or with time of impact
+stepping either island by island or over the whole scene,
+with or without putting resting bodies to sleep
+====================================================
+*/
+static BenchResult RunSceneUpdate( const char * name, const ContactSolverType solverType, const bool islandStepping, const bool sleeping, const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	Scene * scene = BuildScene( numBodies, layout );
+	scene->SetContactSolverType( solverType );
+	scene->SetIslandStepping( islandStepping );
+	scene->SetSleepingEnabled( sleeping );
+	BenchResult result = { name, numBodies, layout, 0, 0.0, 0, 0, 0, 0, 0 };
+
+	BenchClock clock;
+	do {
+		scene->Update( gDt );
+		result.pairs += scene->lastStepStats.numPairs;
+		result.contacts += scene->lastStepStats.numContacts;
+		result.bodyUpdates += scene->lastStepStats.numBodyUpdates;
+		result.iterations++;
+	} while ( clock.Seconds() < options.minTime );
+	result.seconds = clock.Seconds();
+
+	delete scene;
+	return result;
+}
+
+static BenchResult BenchSceneUpdate( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunSceneUpdate( "scene_update", ContactSolverType::SEQUENTIAL_IMPULSE, true, true, numBodies, layout, options );
+}
+
+static BenchResult BenchSceneUpdateNoSleep( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunSceneUpdate( "scene_update_nosleep", ContactSolverType::SEQUENTIAL_IMPULSE, true, false, numBodies, layout, options );
+}
+
+static BenchResult BenchSceneUpdateToi( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunSceneUpdate( "scene_update_toi", ContactSolverType::TIME_OF_IMPACT, true, true, numBodies, layout, options );
+}
+
+static BenchResult BenchSceneUpdateGlobal( const int numBodies, const SceneLayout layout, const BenchOptions & options ) {
+	return RunSceneUpdate( "scene_update_global", ContactSolverType::TIME_OF_IMPACT, false, true, numBodies, layout, options );
+}
+
+/*
+====================================================
+PrintResult
+====================================================
+*/
+static void PrintResult( const BenchResult & result ) {
+	const double nsPerIter = result.seconds * 1e9 / (double)result.iterations;
+	const double nsPerBody = nsPerIter / (double)( result.numBodies > 0 ? result.numBodies : 1 );
+	const double falsePositiveRate = ( result.pairs > 0 ) ? 100.0 * (double)result.falsePositives / (double)result.pairs : 0.0;
+	const long long numCandidates = result.pairs + result.rejectedPairs;
+	const double rejectedRate = ( numCandidates > 0 ) ? 100.0 * (double)result.rejectedPairs / (double)numCandidates : 0.0;
+	const double updatesPerBody = (double)result.bodyUpdates / ( (double)result.iterations * (double)( result.numBodies > 0 ? result.numBodies : 1 ) );
+	printf( "%-22s %6d %-7s %8d iters %12.0f ns/iter %10.1f ns/body %14.0f pairs/s %14.0f contacts/s %5.1f%% false pairs %5.1f%% rejected %8.2f updates/body\n",
+		result.name.c_str(), result.numBodies, SceneLayoutName( result.layout ), result.iterations,
+		nsPerIter, nsPerBody, (double)result.pairs / result.seconds, (double)result.contacts / result.seconds, falsePositiveRate, rejectedRate, updatesPerBody );
+	fflush( stdout );
+}
+
+/*
+====================================================
+WriteJson
+====================================================
+*/
+static bool WriteJson( const char * path, const std::vector< BenchResult > & results ) {
+	FILE * file = fopen( path, "w" );
+	if ( file == nullptr ) {
+		printf( "ERROR: Could not open %s for writing\n", path );
+		return false;
+	}
+	fprintf( file, "{\n  \"benchmarks\": [\n" );
+	for ( int i = 0; i < results.size(); i++ ) {
+		const BenchResult & result = results[ i ];
+		const double nsPerIter = result.seconds * 1e9 / (double)result.iterations;
+		fprintf( file, "    { \"name\": \"%s\", \"bodies\": %d, \"layout\": \"%s\", \"iterations\": %d, "
+			"\"ns_per_iter\": %.1f, \"ns_per_body\": %.3f, \"pairs_per_sec\": %.1f, \"contacts_per_sec\": %.1f, \"false_pairs\": %lld, \"rejected_pairs\": %lld, \"body_updates\": %lld }%s\n",
+			result.name.c_str(), result.numBodies, SceneLayoutName( result.layout ), result.iterations,
+			nsPerIter, nsPerIter / (double)( result.numBodies > 0 ? result.numBodies : 1 ),
+			(double)result.pairs / result.seconds, (double)result.contacts / result.seconds, result.falsePositives, result.rejectedPairs, result.bodyUpdates,
+			( i + 1 < results.size() ) ? "," : "" );
+	}
+	fprintf( file, "  ]\n}\n" );
+	fclose( file );
+	return true;
+}
+
+/*
+====================================================
+PrintUsage
+====================================================
+*/
+static void PrintUsage( const char * exe ) {
+	printf( "usage: %s [--max-bodies N] [--min-time seconds] [--filter name] [--json path]\n", exe );
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	BenchOptions options;
+	for ( int i = 1; i < argc; i++ ) {
+		const bool hasValue = ( i + 1 < argc );
+		if ( 0 == strcmp( argv[ i ], "--max-bodies" ) && hasValue ) {
+			options.maxBodies = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--min-time" ) && hasValue ) {
+			options.minTime = atof( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--filter" ) && hasValue ) {
+			options.filter = argv[ ++i ];
+		} else if ( 0 == strcmp( argv[ i ], "--json" ) && hasValue ) {
+			options.jsonPath = argv[ ++i ];
+		} else {
+			PrintUsage( argv[ 0 ] );
+			return 1;
+		}
+	}
+
+	typedef BenchResult ( *BenchFunction )( const int, const SceneLayout, const BenchOptions & );
+	struct Bench {
+		const char * name;
+		BenchFunction function;
+	};
+	const Bench benches[] = {
+		{ "broadphase", BenchBroadPhase },
+		{ "broadphase_incremental", BenchIncrementalBroadPhase },
+		{ "broadphase_adaptive", BenchAdaptiveBroadPhase },
+		{ "broadphase_tree", BenchTreeBroadPhase },
+		{ "broadphase_grid", BenchGridBroadPhase },
+		{ "narrowphase", BenchNarrowPhase },
+		{ "narrowphase_scalar", BenchScalarNarrowPhase },
+		{ "resolve", BenchResolveContacts },
+		{ "solve", BenchSolveContacts },
+		{ "solve_colored", BenchSolveColoredContacts },
+		{ "scene_update", BenchSceneUpdate },
+		{ "scene_update_nosleep", BenchSceneUpdateNoSleep },
+		{ "scene_update_toi", BenchSceneUpdateToi },
+		{ "scene_update_global", BenchSceneUpdateGlobal },
+	};
+	const int sizes[] = { 10, 100, 1000, 10000 };
+	const SceneLayout layouts[] = { SceneLayout::Dense, SceneLayout::Sparse, SceneLayout::Ground };
+
+	std::vector< BenchResult > results;
+	for ( const Bench & bench : benches ) {
+		if ( options.filter != nullptr && strstr( bench.name, options.filter ) == nullptr ) {
+			continue;
+		}
+		for ( const int numBodies : sizes ) {
+			if ( numBodies > options.maxBodies ) {
+				continue;
+			}
+			for ( const SceneLayout layout : layouts ) {
+				results.push_back( bench.function( numBodies, layout, options ) );
+				PrintResult( results.back() );
+			}
+		}
+	}
+
+	if ( options.jsonPath != nullptr && !WriteJson( options.jsonPath, results ) ) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,100 @@
+//
+//  SceneBuilder.cpp
+//
+#include "SceneBuilder.h"
+#include "../Scene.h"
+#include "../Shape.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <string.h>
+
+/*
+====================================================
+AddGeneratedSpheres
+Dense packs the spheres in a lattice resting on the ground with
+neighbours touching, like a pile of boules, sparse scatters them
+in a box about eight radii apart with a small random velocity and
+ground scatters them on the surface of the earth, rolling, like the
+boules of a petanque end
+====================================================
+*/
+void AddGeneratedSpheres( Scene & scene, const int numBodies, const SceneLayout layout, const unsigned int seed ) {
+	const float bouleRadius = 1.2f;
+	const float cochonnetRadius = 0.6f;
+
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution< float > unit( 0.0f, 1.0f );
+
+	const float earthRadius = 500.0f;	// matches Scene::Initialize
+
+	const int side = ( layout == SceneLayout::Ground ) ? (int)ceilf( sqrtf( (float)numBodies ) ) : (int)ceilf( cbrtf( (float)numBodies ) );
+	const float spacing = ( layout == SceneLayout::Sparse ) ? bouleRadius * 8.0f : bouleRadius * ( layout == SceneLayout::Ground ? 4.0f : 2.0f );
+	const float extent = spacing * (float)side;
+
+	for ( int i = 0; i < numBodies; i++ ) {
+		// Every 13th ball is a cochonnet, like a petanque end with a few players
+		const float radius = ( i % 13 == 0 ) ? cochonnetRadius : bouleRadius;
+
+		Body * body = scene.CreateBody();
+		if ( layout == SceneLayout::Dense ) {
+			const int ix = i % side;
+			const int iy = ( i / side ) % side;
+			const int iz = i / ( side * side );
+			body->position = Vec3( ( ix - side / 2 ) * spacing, ( iy - side / 2 ) * spacing, radius + iz * spacing );
+			body->linearVelocity.Zero();
+		} else if ( layout == SceneLayout::Ground ) {
+			const float x = ( unit( rng ) - 0.5f ) * extent;
+			const float y = ( unit( rng ) - 0.5f ) * extent;
+			const float d2 = std::min( x * x + y * y, earthRadius * earthRadius );
+			body->position = Vec3( x, y, sqrtf( earthRadius * earthRadius - d2 ) - earthRadius + radius );
+			body->linearVelocity = Vec3( unit( rng ) - 0.5f, unit( rng ) - 0.5f, 0.0f ) * 4.0f;
+		} else {
+			body->position = Vec3( ( unit( rng ) - 0.5f ) * extent, ( unit( rng ) - 0.5f ) * extent, radius + unit( rng ) * extent );
+			body->linearVelocity = Vec3( unit( rng ) - 0.5f, unit( rng ) - 0.5f, unit( rng ) - 0.5f ) * 10.0f;
+		}
+		body->orientation = Quat( 0, 0, 0, 1 );
+		body->angularVelocity.Zero();
+		body->SetShape( scene.CreateSphere( radius ) );
+		body->inverseMass = 3.0f;
+		body->elasticity = 0.1f;
+		body->friction = 0.5f;
+		scene.AddBody( body );
+	}
+}
+
+/*
+====================================================
+SceneLayoutName
+====================================================
+*/
+const char * SceneLayoutName( const SceneLayout layout ) {
+	switch ( layout ) {
+		case SceneLayout::Dense:	return "dense";
+		case SceneLayout::Sparse:	return "sparse";
+		case SceneLayout::Ground:	return "ground";
+	}
+	return "unknown";
+}
+
+/*
+====================================================
+ParseSceneLayout
+====================================================
+*/
+bool ParseSceneLayout( const char * name, SceneLayout & layout ) {
+	if ( 0 == strcmp( name, "dense" ) ) {
+		layout = SceneLayout::Dense;
+		return true;
+	}
+	if ( 0 == strcmp( name, "sparse" ) ) {
+		layout = SceneLayout::Sparse;
+		return true;
+	}
+	if ( 0 == strcmp( name, "ground" ) ) {
+		layout = SceneLayout::Ground;
+		return true;
+	}
+	return false;
+}
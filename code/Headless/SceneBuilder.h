@@ -0,0 +1,23 @@
+//
+//  SceneBuilder.h
+//
+#pragma once
+
+class Scene;
+
+enum class SceneLayout {
+	Dense,
+	Sparse,
+	Ground
+};
+
+/*
+====================================================
+SceneBuilder
+Fills a scene with generated spheres so that the physics
+can be stepped without a window or a player throwing balls
+====================================================
+*/
+void AddGeneratedSpheres( Scene & scene, const int numBodies, const SceneLayout layout, const unsigned int seed = 1 );
+const char * SceneLayoutName( const SceneLayout layout );
+bool ParseSceneLayout( const char * name, SceneLayout & layout );
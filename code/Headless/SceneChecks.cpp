@@ -0,0 +1,125 @@
+//
+//  SceneChecks.cpp
+//
+#include "../Scene.h"
+
+#include <stdio.h>
+
+/*
+====================================================
+Checks
+Scenarios the game goes through that have broken before, each
+one returns false when the scene does not hold up
+====================================================
+*/
+static bool Check( const bool condition, const char * what ) {
+	if ( !condition ) {
+		printf( "  FAILED: %s\n", what );
+	}
+	return condition;
+}
+
+static void Step( Scene & scene, const int numSteps ) {
+	for ( int i = 0; i < numSteps; i++ ) {
+		scene.Update( 1.0f / 60.0f );
+		scene.EndUpdate();
+	}
+}
+
+// Throws the next ball of the game and returns its handle once it is in the scene
+static BodyHandle ThrowBall( Scene & scene ) {
+	scene.SpawnBall( Vec3( 0, -30, 10 ), Vec3( 0, 0, 0 ), 1.0f );
+	scene.EndUpdate();
+	const BodyStorage & storage = scene.GetBodyStorage();
+	return storage.GetHandle( storage.Size() - 1 );
+}
+
+static bool RemoveCochonnet() {
+	Scene scene;
+	scene.Initialize();
+	const BodyHandle cochonnet = ThrowBall( scene );
+	Step( scene, 30 );
+
+	bool ok = Check( scene.RemoveBody( cochonnet ), "the cochonnet is removed" );
+	ok = Check( !scene.GetBodyStorage().IsValid( cochonnet ), "its handle no longer resolves" ) && ok;
+	ok = Check( !scene.RemoveBody( cochonnet ), "removing it again fails" ) && ok;
+
+	// The game must not reach the released ball
+	Step( scene, 120 );
+	scene.CheckClosestPlayer();
+	scene.SetWinnerScore();
+
+	// The throw ended with the ball, another one may be thrown
+	const int numBodies = (int)scene.GetBodies().size();
+	ThrowBall( scene );
+	ok = Check( (int)scene.GetBodies().size() == numBodies + 1, "a ball is thrown after the removal" ) && ok;
+	Step( scene, 60 );
+	return ok;
+}
+
+static bool KeepEarth() {
+	Scene scene;
+	scene.Initialize();
+	const BodyHandle earth = scene.GetBodyStorage().GetHandle( 0 );
+
+	bool ok = Check( !scene.RemoveBody( earth ), "the earth is not removed" );
+	ok = Check( scene.GetBodyStorage().IsValid( earth ), "its handle still resolves" ) && ok;
+	ThrowBall( scene );
+	Step( scene, 60 );
+	return ok;
+}
+
+// Drops a sphere on the earth and returns its handle
+static BodyHandle AddSphere( Scene & scene, const Vec3 & position ) {
+	Body * body = scene.CreateBody();
+	body->SetShape( scene.CreateSphere( 1.0f ) );
+	body->position = position;
+	body->inverseMass = 1.0f;
+	return scene.AddBody( body );
+}
+
+static bool KeepOtherManifolds() {
+	Scene scene;
+	scene.Initialize();
+	const BodyHandle earth = scene.GetBodyStorage().GetHandle( 0 );
+	const BodyHandle first = AddSphere( scene, Vec3( -5, 0, 0.9f ) );
+	const BodyHandle last = AddSphere( scene, Vec3( 5, 0, 0.9f ) );
+	Step( scene, 10 );
+
+	const ContactCache & cache = scene.GetContactCache();
+	bool ok = Check( cache.Find( earth, first ) != nullptr, "the first sphere touches the earth" );
+	ok = Check( cache.Find( earth, last ) != nullptr, "the last sphere touches the earth" ) && ok;
+
+	// The last sphere moves to the index of the first one and keeps its points
+	scene.RemoveBody( first );
+	ok = Check( cache.Find( earth, first ) == nullptr, "the manifold of the removed sphere expires" ) && ok;
+	ok = Check( cache.Find( earth, last ) != nullptr, "the manifold of the moved sphere is kept" ) && ok;
+	Step( scene, 1 );
+	ok = Check( cache.GetNumMatched() > 0, "the moved sphere is warm started" ) && ok;
+	return ok;
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	struct NamedCheck {
+		const char * name;
+		bool ( *run )();
+	};
+	const NamedCheck checks[] = {
+		{ "remove_cochonnet", RemoveCochonnet },
+		{ "keep_earth", KeepEarth },
+		{ "keep_other_manifolds", KeepOtherManifolds },
+	};
+
+	int numFailed = 0;
+	for ( const NamedCheck & check : checks ) {
+		const bool ok = check.run();
+		printf( "%-20s %s\n", check.name, ok ? "ok" : "FAILED" );
+		numFailed += ok ? 0 : 1;
+	}
+	return ( numFailed == 0 ) ? 0 : 1;
+}
@@ -1,17 +1,37 @@
 ﻿#include "Intersections.h"
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define INTERSECTIONS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INTERSECTIONS_SSE
+#endif
+
 bool Intersections::Intersect(Body& a, Body& b,
 const float dt, Contact& contact)
 {
 	contact.a = &a;
 	contact.b = &b;
+	return FindContact(a, b, dt, contact);
+}
+
+static Vec3 WorldSpaceToBodySpace(const Body& body, const Vec3& position, const Quat& orientation, const Vec3& worldPoint)
+{
+	const Vec3 centerOfMass = position + orientation.RotatePoint(body.shape->GetCenterOfMass());
+	return orientation.Inverse().RotatePoint(worldPoint - centerOfMass);
+}
+
+bool Intersections::FindContact(const Body& a, const Body& b,
+const float dt, Contact& contact)
+{
 	const Vec3 ab = b.position - a.position;
 	contact.normal = ab;
 	contact.normal.Normalize();
 	if (a.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE
 	&& b.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE) {
-		ShapeSphere* sphereA = static_cast<ShapeSphere*>(a.shape);
-		ShapeSphere* sphereB = static_cast<ShapeSphere*>(b.shape);
+		const ShapeSphere* sphereA = static_cast<const ShapeSphere*>(a.shape);
+		const ShapeSphere* sphereB = static_cast<const ShapeSphere*>(b.shape);
 		Vec3 posA = a.position;
 		Vec3 posB = b.position;
 		Vec3 valA = a.linearVelocity;
@@ -21,30 +41,37 @@ const float dt, Contact& contact)
 		contact.ptOnAWorldSpace, contact.ptOnBWorldSpace,
 		contact.timeOfImpact))
 		{
-			// Step bodies forward to get local space collision points
-			a.Update(contact.timeOfImpact);
-			b.Update(contact.timeOfImpact);
-			// Convert world space contacts to local space
-			contact.ptOnALocalSpace =
-			a.WorldSpaceToBodySpace(contact.ptOnAWorldSpace);
-			contact.ptOnBLocalSpace =
-			b.WorldSpaceToBodySpace(contact.ptOnBWorldSpace);
-			Vec3 ab = a.position - b.position;
-			contact.normal = ab;
-			contact.normal.Normalize();
-			// Unwind time step
-			a.Update(-contact.timeOfImpact);
-			b.Update(-contact.timeOfImpact);
-			// Calculate separation distance
-			float r = ab.GetMagnitude()
-			- (sphereA->radius + sphereB->radius);
-			contact.separationDistance = r;
+			FinishSphereSphereContact(a, b, contact);
 			return true;
 		}
 	}
 	return false;
 }
 
+void Intersections::FinishSphereSphereContact(const Body& a, const Body& b, Contact& contact)
+{
+	const ShapeSphere* sphereA = static_cast<const ShapeSphere*>(a.shape);
+	const ShapeSphere* sphereB = static_cast<const ShapeSphere*>(b.shape);
+	// Where the bodies are at the time of impact, to get local space
+	// collision points (instead of stepping them there and back)
+	Vec3 positionA, positionB;
+	Quat orientationA, orientationB;
+	a.GetTransformAt(contact.timeOfImpact, positionA, orientationA);
+	b.GetTransformAt(contact.timeOfImpact, positionB, orientationB);
+	// Convert world space contacts to local space
+	contact.ptOnALocalSpace =
+	WorldSpaceToBodySpace(a, positionA, orientationA, contact.ptOnAWorldSpace);
+	contact.ptOnBLocalSpace =
+	WorldSpaceToBodySpace(b, positionB, orientationB, contact.ptOnBWorldSpace);
+	Vec3 ab = positionA - positionB;
+	contact.normal = ab;
+	contact.normal.Normalize();
+	// Calculate separation distance
+	float r = ab.GetMagnitude()
+	- (sphereA->radius + sphereB->radius);
+	contact.separationDistance = r;
+}
+
 bool Intersections::RaySphere(const Vec3& rayStart, const Vec3& rayDir, const Vec3& sphereCenter, const float sphereRadius, float& t0, float& t1)
 {
 	const Vec3& s = sphereCenter - rayStart;
@@ -68,6 +95,14 @@ bool Intersections::SphereSphereDynamic(
 const ShapeSphere& shapeA, const ShapeSphere& shapeB,
 const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB,
 const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact)
+{
+	return SphereSphereDynamic(shapeA.radius, shapeB.radius, posA, posB, velA, velB, dt, ptOnA, ptOnB, timeOfImpact);
+}
+
+bool Intersections::SphereSphereDynamic(
+const float radiusA, const float radiusB,
+const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB,
+const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact)
 {
 	const Vec3 relativeVelocity = velA - velB;
 	const Vec3 startPtA = posA;
@@ -79,14 +114,14 @@ const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact)
 	{
 		// Ray is too short, just check if already intersecting
 		Vec3 ab = posB - posA;
-		float radius = shapeA.radius + shapeB.radius + 0.001f;
+		float radius = radiusA + radiusB + 0.001f;
 		if (ab.GetLengthSqr() > radius * radius)
 		{
 			return false;
 		}
 	}
 	else if (!RaySphere(startPtA, rayDir, posB,
-	shapeA.radius + shapeB.radius, t0, t1))
+	radiusA + radiusB, t0, t1))
 	{
 		return false;
 	}
@@ -109,7 +144,195 @@ const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact)
 	Vec3 newPosB = posB + velB * timeOfImpact;
 	Vec3 ab = newPosB - newPosA;
 	ab.Normalize();
-	ptOnA = newPosA + ab * shapeA.radius;
-	ptOnB = newPosB - ab * shapeB.radius;
+	ptOnA = newPosA + ab * radiusA;
+	ptOnB = newPosB - ab * radiusB;
 	return true;
-}
\ No newline at end of file
+}
+
+void SphereSphereBatch::Add(const Body& a, const Body& b)
+{
+	posAX[num] = a.position.x;
+	posAY[num] = a.position.y;
+	posAZ[num] = a.position.z;
+	posBX[num] = b.position.x;
+	posBY[num] = b.position.y;
+	posBZ[num] = b.position.z;
+	velAX[num] = a.linearVelocity.x;
+	velAY[num] = a.linearVelocity.y;
+	velAZ[num] = a.linearVelocity.z;
+	velBX[num] = b.linearVelocity.x;
+	velBY[num] = b.linearVelocity.y;
+	velBZ[num] = b.linearVelocity.z;
+	radiusA[num] = static_cast<const ShapeSphere*>(a.shape)->radius;
+	radiusB[num] = static_cast<const ShapeSphere*>(b.shape)->radius;
+	++num;
+}
+
+#if defined(INTERSECTIONS_AVX) || defined(INTERSECTIONS_SSE)
+// Thin wrappers so the kernel below is written once for both widths
+#if defined(INTERSECTIONS_AVX)
+typedef __m256 Lanes;
+static const int NUM_LANES = 8;
+static inline Lanes Load(const float* p) { return _mm256_load_ps(p); }
+static inline void Store(float* p, const Lanes v) { _mm256_store_ps(p, v); }
+static inline Lanes Splat(const float f) { return _mm256_set1_ps(f); }
+static inline Lanes Add(const Lanes a, const Lanes b) { return _mm256_add_ps(a, b); }
+static inline Lanes Sub(const Lanes a, const Lanes b) { return _mm256_sub_ps(a, b); }
+static inline Lanes Mul(const Lanes a, const Lanes b) { return _mm256_mul_ps(a, b); }
+static inline Lanes Div(const Lanes a, const Lanes b) { return _mm256_div_ps(a, b); }
+static inline Lanes Sqrt(const Lanes a) { return _mm256_sqrt_ps(a); }
+static inline Lanes Less(const Lanes a, const Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline Lanes Greater(const Lanes a, const Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline Lanes Equal(const Lanes a, const Lanes b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline Lanes And(const Lanes a, const Lanes b) { return _mm256_and_ps(a, b); }
+static inline Lanes AndNot(const Lanes a, const Lanes b) { return _mm256_andnot_ps(a, b); }
+static inline Lanes Select(const Lanes mask, const Lanes a, const Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+static inline int Mask(const Lanes a) { return _mm256_movemask_ps(a); }
+#else
+typedef __m128 Lanes;
+static const int NUM_LANES = 4;
+static inline Lanes Load(const float* p) { return _mm_load_ps(p); }
+static inline void Store(float* p, const Lanes v) { _mm_store_ps(p, v); }
+static inline Lanes Splat(const float f) { return _mm_set1_ps(f); }
+static inline Lanes Add(const Lanes a, const Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes Sub(const Lanes a, const Lanes b) { return _mm_sub_ps(a, b); }
+static inline Lanes Mul(const Lanes a, const Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes Div(const Lanes a, const Lanes b) { return _mm_div_ps(a, b); }
+static inline Lanes Sqrt(const Lanes a) { return _mm_sqrt_ps(a); }
+static inline Lanes Less(const Lanes a, const Lanes b) { return _mm_cmplt_ps(a, b); }
+static inline Lanes Greater(const Lanes a, const Lanes b) { return _mm_cmpgt_ps(a, b); }
+static inline Lanes Equal(const Lanes a, const Lanes b) { return _mm_cmpeq_ps(a, b); }
+static inline Lanes And(const Lanes a, const Lanes b) { return _mm_and_ps(a, b); }
+static inline Lanes AndNot(const Lanes a, const Lanes b) { return _mm_andnot_ps(a, b); }
+static inline Lanes Select(const Lanes mask, const Lanes a, const Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline int Mask(const Lanes a) { return _mm_movemask_ps(a); }
+#endif
+
+static inline Lanes Dot(const Lanes ax, const Lanes ay, const Lanes az, const Lanes bx, const Lanes by, const Lanes bz)
+{
+	// Same order as Vec3::Dot so the lanes round like the scalar path
+	return Add(Add(Mul(ax, bx), Mul(ay, by)), Mul(az, bz));
+}
+#endif
+
+int Intersections::SphereSphereDynamicBatch(SphereSphereBatch& batch, const float dt, int* hits)
+{
+	int numHits = 0;
+	int i = 0;
+
+#if defined(INTERSECTIONS_AVX) || defined(INTERSECTIONS_SSE)
+	// Both branches of SphereSphereDynamic and RaySphere are computed for
+	// every lane, then the masks pick the result each lane would have taken
+	const Lanes zero = Splat(0.0f);
+	const Lanes dtLanes = Splat(dt);
+	for (; i + NUM_LANES <= batch.num; i += NUM_LANES) {
+		const Lanes posAX = Load(batch.posAX + i);
+		const Lanes posAY = Load(batch.posAY + i);
+		const Lanes posAZ = Load(batch.posAZ + i);
+		const Lanes posBX = Load(batch.posBX + i);
+		const Lanes posBY = Load(batch.posBY + i);
+		const Lanes posBZ = Load(batch.posBZ + i);
+		const Lanes velAX = Load(batch.velAX + i);
+		const Lanes velAY = Load(batch.velAY + i);
+		const Lanes velAZ = Load(batch.velAZ + i);
+		const Lanes velBX = Load(batch.velBX + i);
+		const Lanes velBY = Load(batch.velBY + i);
+		const Lanes velBZ = Load(batch.velBZ + i);
+		const Lanes radiusA = Load(batch.radiusA + i);
+		const Lanes radiusB = Load(batch.radiusB + i);
+
+		// The ray of A relative to B
+		const Lanes rayDirX = Sub(Add(posAX, Mul(Sub(velAX, velBX), dtLanes)), posAX);
+		const Lanes rayDirY = Sub(Add(posAY, Mul(Sub(velAY, velBY), dtLanes)), posAY);
+		const Lanes rayDirZ = Sub(Add(posAZ, Mul(Sub(velAZ, velBZ), dtLanes)), posAZ);
+		const Lanes abX = Sub(posBX, posAX);
+		const Lanes abY = Sub(posBY, posAY);
+		const Lanes abZ = Sub(posBZ, posAZ);
+		const Lanes a = Dot(rayDirX, rayDirY, rayDirZ, rayDirX, rayDirY, rayDirZ);
+		const Lanes abLengthSqr = Dot(abX, abY, abZ, abX, abY, abZ);
+		const Lanes isShortRay = Less(a, Splat(0.001f * 0.001f));
+
+		// Ray too short, just check if already intersecting
+		const Lanes shortRadius = Add(Add(radiusA, radiusB), Splat(0.001f));
+		const Lanes shortHit = AndNot(Greater(abLengthSqr, Mul(shortRadius, shortRadius)), isShortRay);
+
+		// Ray against the sphere of both radii around B
+		const Lanes radius = Add(radiusA, radiusB);
+		const Lanes b = Dot(abX, abY, abZ, rayDirX, rayDirY, rayDirZ);
+		const Lanes c = Sub(abLengthSqr, Mul(radius, radius));
+		const Lanes delta = Sub(Mul(b, b), Mul(a, c));
+		const Lanes inverseA = Div(Splat(1.0f), a);
+		const Lanes isLongRay = AndNot(isShortRay, Equal(zero, zero));
+		const Lanes rayHit = AndNot(Less(delta, zero), isLongRay);
+		const Lanes deltaRoot = Sqrt(And(delta, rayHit));
+		const Lanes rayT0 = Mul(Sub(b, deltaRoot), inverseA);
+		const Lanes rayT1 = Mul(Add(b, deltaRoot), inverseA);
+
+		// Change from [0, 1] to [0, dt], a short ray has t0 = t1 = 0
+		const Lanes t0 = Mul(Select(isShortRay, zero, rayT0), dtLanes);
+		const Lanes t1 = Mul(Select(isShortRay, zero, rayT1), dtLanes);
+		const Lanes timeOfImpact = Select(Less(t0, zero), zero, t0);
+		Lanes hit = Select(isShortRay, shortHit, rayHit);
+		hit = AndNot(Less(t1, zero), hit);
+		hit = AndNot(Greater(timeOfImpact, dtLanes), hit);
+
+		const int mask = Mask(hit);
+		if (mask == 0) {
+			continue;
+		}
+
+		// Points of collision at the time of impact
+		const Lanes newPosAX = Add(posAX, Mul(velAX, timeOfImpact));
+		const Lanes newPosAY = Add(posAY, Mul(velAY, timeOfImpact));
+		const Lanes newPosAZ = Add(posAZ, Mul(velAZ, timeOfImpact));
+		const Lanes newPosBX = Add(posBX, Mul(velBX, timeOfImpact));
+		const Lanes newPosBY = Add(posBY, Mul(velBY, timeOfImpact));
+		const Lanes newPosBZ = Add(posBZ, Mul(velBZ, timeOfImpact));
+		Lanes normalX = Sub(newPosBX, newPosAX);
+		Lanes normalY = Sub(newPosBY, newPosAY);
+		Lanes normalZ = Sub(newPosBZ, newPosAZ);
+		// Vec3::Normalize, which leaves the vector alone when it cannot be normalized
+		const Lanes inverseMagnitude = Div(Splat(1.0f), Sqrt(Dot(normalX, normalY, normalZ, normalX, normalY, normalZ)));
+		const Lanes zeroTimesInverse = Mul(zero, inverseMagnitude);
+		const Lanes isFinite = Equal(zeroTimesInverse, zeroTimesInverse);
+		normalX = Select(isFinite, Mul(normalX, inverseMagnitude), normalX);
+		normalY = Select(isFinite, Mul(normalY, inverseMagnitude), normalY);
+		normalZ = Select(isFinite, Mul(normalZ, inverseMagnitude), normalZ);
+
+		Store(batch.timeOfImpact + i, timeOfImpact);
+		Store(batch.ptOnAX + i, Add(newPosAX, Mul(normalX, radiusA)));
+		Store(batch.ptOnAY + i, Add(newPosAY, Mul(normalY, radiusA)));
+		Store(batch.ptOnAZ + i, Add(newPosAZ, Mul(normalZ, radiusA)));
+		Store(batch.ptOnBX + i, Sub(newPosBX, Mul(normalX, radiusB)));
+		Store(batch.ptOnBY + i, Sub(newPosBY, Mul(normalY, radiusB)));
+		Store(batch.ptOnBZ + i, Sub(newPosBZ, Mul(normalZ, radiusB)));
+		for (int lane = 0; lane < NUM_LANES; lane++) {
+			if (mask & (1 << lane)) {
+				hits[numHits++] = i + lane;
+			}
+		}
+	}
+#endif
+
+	// Remaining pairs go through the scalar path
+	for (; i < batch.num; i++) {
+		Vec3 ptOnA;
+		Vec3 ptOnB;
+		float timeOfImpact;
+		if (SphereSphereDynamic(batch.radiusA[i], batch.radiusB[i],
+		Vec3(batch.posAX[i], batch.posAY[i], batch.posAZ[i]), Vec3(batch.posBX[i], batch.posBY[i], batch.posBZ[i]),
+		Vec3(batch.velAX[i], batch.velAY[i], batch.velAZ[i]), Vec3(batch.velBX[i], batch.velBY[i], batch.velBZ[i]),
+		dt, ptOnA, ptOnB, timeOfImpact))
+		{
+			batch.timeOfImpact[i] = timeOfImpact;
+			batch.ptOnAX[i] = ptOnA.x;
+			batch.ptOnAY[i] = ptOnA.y;
+			batch.ptOnAZ[i] = ptOnA.z;
+			batch.ptOnBX[i] = ptOnB.x;
+			batch.ptOnBY[i] = ptOnB.y;
+			batch.ptOnBZ[i] = ptOnB.z;
+			hits[numHits++] = i;
+		}
+	}
+	return numHits;
+}
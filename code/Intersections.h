@@ -3,13 +3,64 @@
 #include "Contact.h"
 #include "Shape.h"
 
+// Sphere pairs packed as a structure of arrays, so that the
+// time of impact can be solved for 4 (SSE) or 8 (AVX) pairs at once
+struct SphereSphereBatch
+{
+	static const int MAX_PAIRS = 64;
+
+	void Clear() { num = 0; }
+	bool IsFull() const { return num == MAX_PAIRS; }
+	void Add(const Body& a, const Body& b);
+
+	int num = 0;
+
+	// Inputs
+	alignas(32) float posAX[MAX_PAIRS];
+	alignas(32) float posAY[MAX_PAIRS];
+	alignas(32) float posAZ[MAX_PAIRS];
+	alignas(32) float posBX[MAX_PAIRS];
+	alignas(32) float posBY[MAX_PAIRS];
+	alignas(32) float posBZ[MAX_PAIRS];
+	alignas(32) float velAX[MAX_PAIRS];
+	alignas(32) float velAY[MAX_PAIRS];
+	alignas(32) float velAZ[MAX_PAIRS];
+	alignas(32) float velBX[MAX_PAIRS];
+	alignas(32) float velBY[MAX_PAIRS];
+	alignas(32) float velBZ[MAX_PAIRS];
+	alignas(32) float radiusA[MAX_PAIRS];
+	alignas(32) float radiusB[MAX_PAIRS];
+
+	// Outputs, only meaningful for the pairs reported as hits
+	alignas(32) float timeOfImpact[MAX_PAIRS];
+	alignas(32) float ptOnAX[MAX_PAIRS];
+	alignas(32) float ptOnAY[MAX_PAIRS];
+	alignas(32) float ptOnAZ[MAX_PAIRS];
+	alignas(32) float ptOnBX[MAX_PAIRS];
+	alignas(32) float ptOnBY[MAX_PAIRS];
+	alignas(32) float ptOnBZ[MAX_PAIRS];
+};
+
 class Intersections
 {
 public:
 	static bool Intersect(Body& a, Body& b, const float dt, Contact& contact);
+	// Same test without touching the bodies, the contact points come from where
+	// the bodies will be at the time of impact. Fills everything but contact.a/b,
+	// so pairs can be tested from several threads at once.
+	static bool FindContact(const Body& a, const Body& b, const float dt, Contact& contact);
 	static bool RaySphere(const Vec3& rayStart, const Vec3& rayDir, const Vec3& sphereCenter, float sphereRadius, float& t0,
 	               float& t1);
+	// Completes a sphere-sphere contact whose time of impact and world points are set
+	static void FinishSphereSphereContact(const Body& a, const Body& b, Contact& contact);
+	// SphereSphereDynamic over a whole batch, writes the index of every pair that
+	// collides within dt to hits and returns how many. Same math as the scalar path.
+	static int SphereSphereDynamicBatch(SphereSphereBatch& batch, const float dt, int* hits);
 	static bool SphereSphereDynamic(const ShapeSphere& shapeA, const ShapeSphere& shapeB, const Vec3& posA, const Vec3& posB,
 	                         const Vec3& velA, const Vec3& velB, float dt, Vec3& ptOnA, Vec3& ptOnB,
 	                         float& timeOfImpact);
+	// Same test on the radii alone, for callers that have no shape at hand
+	static bool SphereSphereDynamic(const float radiusA, const float radiusB, const Vec3& posA, const Vec3& posB,
+	                         const Vec3& velA, const Vec3& velB, float dt, Vec3& ptOnA, Vec3& ptOnB,
+	                         float& timeOfImpact);
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "JobSystem.h"
+
+// Set while a thread runs tasks, a nested ParallelFor must not replace the job it is part of
+static thread_local bool isRunningTasks = false;
+
+JobSystem::JobSystem(const int numThreads)
+	: nextTask(0)
+{
+	int count = numThreads;
+	if (count <= 0) {
+		count = (int)std::thread::hardware_concurrency();
+	}
+	if (count < 1) {
+		count = 1;
+	}
+	for (int i = 1; i < count; i++) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wakeWorkers.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+void JobSystem::ParallelFor(const int count, const std::function<void(int task)>& task)
+{
+	if (count <= 0) {
+		return;
+	}
+	if (workers.empty() || count == 1 || isRunningTasks) {
+		for (int i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> callerLock(callerMutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		numTasks = count;
+		nextTask = 0;
+		numBusyWorkers = (int)workers.size();
+		++generation;
+	}
+	wakeWorkers.notify_all();
+
+	RunTasks();
+
+	// Wait for the workers to leave RunTasks too, the task
+	// function dies with this frame once we return
+	std::unique_lock<std::mutex> lock(mutex);
+	jobDone.wait(lock, [this]() { return numBusyWorkers == 0; });
+	currentTask = nullptr;
+}
+
+void JobSystem::RunTasks()
+{
+	isRunningTasks = true;
+	for (;;) {
+		const int i = nextTask.fetch_add(1);
+		if (i >= numTasks) {
+			break;
+		}
+		(*currentTask)(i);
+	}
+	isRunningTasks = false;
+}
+
+void JobSystem::WorkerLoop()
+{
+	unsigned int seenGeneration = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeWorkers.wait(lock, [&]() { return quit || generation != seenGeneration; });
+			if (quit) {
+				return;
+			}
+			seenGeneration = generation;
+		}
+
+		RunTasks();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--numBusyWorkers == 0) {
+			jobDone.notify_one();
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads shared by the physics. ParallelFor hands
+// out task indices to the workers and the calling thread, and returns once
+// every task ran. Which thread runs a task is not fixed, so tasks must only
+// write to their own outputs for the results to be deterministic.
+// There is one job in flight at a time: calls from other threads wait for
+// it to finish, and a ParallelFor called from inside a task runs serially
+// on the thread running that task.
+class JobSystem
+{
+public:
+	// Zero threads uses one per hardware thread
+	explicit JobSystem(const int numThreads = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	static JobSystem& Get();
+
+	// Worker threads plus the caller
+	int GetNumThreads() const { return (int)workers.size() + 1; }
+
+	void ParallelFor(const int numTasks, const std::function<void(int task)>& task);
+
+private:
+	void WorkerLoop();
+	void RunTasks();
+
+	std::vector<std::thread> workers;
+	std::mutex callerMutex;	// held by the thread whose job is in flight
+	std::mutex mutex;
+	std::condition_variable wakeWorkers;
+	std::condition_variable jobDone;
+
+	const std::function<void(int task)>* currentTask = nullptr;
+	int numTasks = 0;
+	std::atomic<int> nextTask;
+	int numBusyWorkers = 0;
+	unsigned int generation = 0;
+	bool quit = false;
+};
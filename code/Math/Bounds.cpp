@@ -17,6 +17,16 @@ bool Bounds::DoesIntersect( const Bounds & rhs ) const {
 	return true;
 }
 
+bool Bounds::Contains( const Bounds & rhs ) const {
+	if ( rhs.mins.x < mins.x || rhs.mins.y < mins.y || rhs.mins.z < mins.z ) {
+		return false;
+	}
+	if ( rhs.maxs.x > maxs.x || rhs.maxs.y > maxs.y || rhs.maxs.z > maxs.z ) {
+		return false;
+	}
+	return true;
+}
+
 void Bounds::Expand( const Vec3 * pts, const int num ) {
 	for ( int i = 0; i < num; i++ ) {
 		Expand( pts[ i ] );
@@ -0,0 +1,176 @@
+//
+//	BoundsSoA.cpp
+//
+#include "BoundsSoA.h"
+#include "../Broadphase.h"
+#include "../FrameArena.h"
+
+#if defined( __AVX__ )
+#include <immintrin.h>
+#define BOUNDS_SOA_AVX
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define BOUNDS_SOA_SSE
+#endif
+
+/*
+====================================================
+BoundsSoA::Resize
+====================================================
+*/
+void BoundsSoA::Resize( const int num ) {
+	storage.resize( num * 6 );
+	SetLanes( storage.data(), num );
+}
+
+void BoundsSoA::Resize( const int num, FrameArena & arena ) {
+	SetLanes( arena.Allocate< float >( num * 6 ), num );
+}
+
+/*
+====================================================
+BoundsSoA::SetLanes
+====================================================
+*/
+void BoundsSoA::SetLanes( float * lanes, const int num ) {
+	minX = lanes;
+	minY = lanes + num;
+	minZ = lanes + num * 2;
+	maxX = lanes + num * 3;
+	maxY = lanes + num * 4;
+	maxZ = lanes + num * 5;
+	numBounds = num;
+}
+
+/*
+====================================================
+BoundsSoA::Set
+====================================================
+*/
+void BoundsSoA::Set( const int idx, const Bounds & bounds ) {
+	minX[ idx ] = bounds.mins.x;
+	minY[ idx ] = bounds.mins.y;
+	minZ[ idx ] = bounds.mins.z;
+	maxX[ idx ] = bounds.maxs.x;
+	maxY[ idx ] = bounds.maxs.y;
+	maxZ[ idx ] = bounds.maxs.z;
+}
+
+/*
+====================================================
+BoundsSoA::Overlaps
+Same test as Bounds::DoesIntersect
+====================================================
+*/
+bool BoundsSoA::Overlaps( const int a, const int b ) const {
+	if ( maxX[ a ] < minX[ b ] || maxY[ a ] < minY[ b ] || maxZ[ a ] < minZ[ b ] ) {
+		return false;
+	}
+	if ( maxX[ b ] < minX[ a ] || maxY[ b ] < minY[ a ] || maxZ[ b ] < minZ[ a ] ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+====================================================
+BoundsSoA::OverlapRun
+====================================================
+*/
+int BoundsSoA::OverlapRun( const int idx, const int first, const int last, int * overlapping ) const {
+	int num = 0;
+	int j = first;
+
+#if defined( BOUNDS_SOA_AVX )
+	const __m256 aMinX = _mm256_set1_ps( minX[ idx ] );
+	const __m256 aMinY = _mm256_set1_ps( minY[ idx ] );
+	const __m256 aMinZ = _mm256_set1_ps( minZ[ idx ] );
+	const __m256 aMaxX = _mm256_set1_ps( maxX[ idx ] );
+	const __m256 aMaxY = _mm256_set1_ps( maxY[ idx ] );
+	const __m256 aMaxZ = _mm256_set1_ps( maxZ[ idx ] );
+	for ( ; j + 8 <= last; j += 8 ) {
+		// Overlap on an axis is bMin <= aMax && aMin <= bMax
+		__m256 overlap = _mm256_and_ps( _mm256_cmp_ps( _mm256_loadu_ps( &minX[ j ] ), aMaxX, _CMP_LE_OQ ), _mm256_cmp_ps( aMinX, _mm256_loadu_ps( &maxX[ j ] ), _CMP_LE_OQ ) );
+		overlap = _mm256_and_ps( overlap, _mm256_and_ps( _mm256_cmp_ps( _mm256_loadu_ps( &minY[ j ] ), aMaxY, _CMP_LE_OQ ), _mm256_cmp_ps( aMinY, _mm256_loadu_ps( &maxY[ j ] ), _CMP_LE_OQ ) ) );
+		overlap = _mm256_and_ps( overlap, _mm256_and_ps( _mm256_cmp_ps( _mm256_loadu_ps( &minZ[ j ] ), aMaxZ, _CMP_LE_OQ ), _mm256_cmp_ps( aMinZ, _mm256_loadu_ps( &maxZ[ j ] ), _CMP_LE_OQ ) ) );
+		const int mask = _mm256_movemask_ps( overlap );
+		for ( int lane = 0; mask != 0 && lane < 8; lane++ ) {
+			if ( mask & ( 1 << lane ) ) {
+				overlapping[ num++ ] = j + lane;
+			}
+		}
+	}
+#elif defined( BOUNDS_SOA_SSE )
+	const __m128 aMinX = _mm_set1_ps( minX[ idx ] );
+	const __m128 aMinY = _mm_set1_ps( minY[ idx ] );
+	const __m128 aMinZ = _mm_set1_ps( minZ[ idx ] );
+	const __m128 aMaxX = _mm_set1_ps( maxX[ idx ] );
+	const __m128 aMaxY = _mm_set1_ps( maxY[ idx ] );
+	const __m128 aMaxZ = _mm_set1_ps( maxZ[ idx ] );
+	for ( ; j + 4 <= last; j += 4 ) {
+		// Overlap on an axis is bMin <= aMax && aMin <= bMax
+		__m128 overlap = _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( &minX[ j ] ), aMaxX ), _mm_cmple_ps( aMinX, _mm_loadu_ps( &maxX[ j ] ) ) );
+		overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( &minY[ j ] ), aMaxY ), _mm_cmple_ps( aMinY, _mm_loadu_ps( &maxY[ j ] ) ) ) );
+		overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( &minZ[ j ] ), aMaxZ ), _mm_cmple_ps( aMinZ, _mm_loadu_ps( &maxZ[ j ] ) ) ) );
+		const int mask = _mm_movemask_ps( overlap );
+		for ( int lane = 0; mask != 0 && lane < 4; lane++ ) {
+			if ( mask & ( 1 << lane ) ) {
+				overlapping[ num++ ] = j + lane;
+			}
+		}
+	}
+#endif
+
+	for ( ; j < last; j++ ) {
+		if ( Overlaps( idx, j ) ) {
+			overlapping[ num++ ] = j;
+		}
+	}
+	return num;
+}
+
+/*
+====================================================
+BoundsSoA::FilterPairs
+====================================================
+*/
+int BoundsSoA::FilterPairs( const CollisionPair * pairs, const int num, CollisionPair * kept ) const {
+	int numKept = 0;
+	int i = 0;
+
+#if defined( BOUNDS_SOA_SSE ) || defined( BOUNDS_SOA_AVX )
+	// The pairs index the arrays at random, gather four pairs into lanes
+	for ( ; i + 4 <= num; i += 4 ) {
+		const CollisionPair * p = pairs + i;
+		const __m128 aMinX = _mm_setr_ps( minX[ p[ 0 ].a ], minX[ p[ 1 ].a ], minX[ p[ 2 ].a ], minX[ p[ 3 ].a ] );
+		const __m128 aMaxX = _mm_setr_ps( maxX[ p[ 0 ].a ], maxX[ p[ 1 ].a ], maxX[ p[ 2 ].a ], maxX[ p[ 3 ].a ] );
+		const __m128 bMinX = _mm_setr_ps( minX[ p[ 0 ].b ], minX[ p[ 1 ].b ], minX[ p[ 2 ].b ], minX[ p[ 3 ].b ] );
+		const __m128 bMaxX = _mm_setr_ps( maxX[ p[ 0 ].b ], maxX[ p[ 1 ].b ], maxX[ p[ 2 ].b ], maxX[ p[ 3 ].b ] );
+		const __m128 aMinY = _mm_setr_ps( minY[ p[ 0 ].a ], minY[ p[ 1 ].a ], minY[ p[ 2 ].a ], minY[ p[ 3 ].a ] );
+		const __m128 aMaxY = _mm_setr_ps( maxY[ p[ 0 ].a ], maxY[ p[ 1 ].a ], maxY[ p[ 2 ].a ], maxY[ p[ 3 ].a ] );
+		const __m128 bMinY = _mm_setr_ps( minY[ p[ 0 ].b ], minY[ p[ 1 ].b ], minY[ p[ 2 ].b ], minY[ p[ 3 ].b ] );
+		const __m128 bMaxY = _mm_setr_ps( maxY[ p[ 0 ].b ], maxY[ p[ 1 ].b ], maxY[ p[ 2 ].b ], maxY[ p[ 3 ].b ] );
+		const __m128 aMinZ = _mm_setr_ps( minZ[ p[ 0 ].a ], minZ[ p[ 1 ].a ], minZ[ p[ 2 ].a ], minZ[ p[ 3 ].a ] );
+		const __m128 aMaxZ = _mm_setr_ps( maxZ[ p[ 0 ].a ], maxZ[ p[ 1 ].a ], maxZ[ p[ 2 ].a ], maxZ[ p[ 3 ].a ] );
+		const __m128 bMinZ = _mm_setr_ps( minZ[ p[ 0 ].b ], minZ[ p[ 1 ].b ], minZ[ p[ 2 ].b ], minZ[ p[ 3 ].b ] );
+		const __m128 bMaxZ = _mm_setr_ps( maxZ[ p[ 0 ].b ], maxZ[ p[ 1 ].b ], maxZ[ p[ 2 ].b ], maxZ[ p[ 3 ].b ] );
+
+		__m128 overlap = _mm_and_ps( _mm_cmple_ps( bMinX, aMaxX ), _mm_cmple_ps( aMinX, bMaxX ) );
+		overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( bMinY, aMaxY ), _mm_cmple_ps( aMinY, bMaxY ) ) );
+		overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( bMinZ, aMaxZ ), _mm_cmple_ps( aMinZ, bMaxZ ) ) );
+		const int mask = _mm_movemask_ps( overlap );
+		for ( int lane = 0; lane < 4; lane++ ) {
+			if ( mask & ( 1 << lane ) ) {
+				kept[ numKept++ ] = p[ lane ];
+			}
+		}
+	}
+#endif
+
+	for ( ; i < num; i++ ) {
+		if ( Overlaps( pairs[ i ].a, pairs[ i ].b ) ) {
+			kept[ numKept++ ] = pairs[ i ];
+		}
+	}
+	return numKept;
+}
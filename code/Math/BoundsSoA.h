@@ -0,0 +1,54 @@
+//
+//	BoundsSoA.h
+//
+#pragma once
+#include <vector>
+#include "Bounds.h"
+
+struct CollisionPair;
+class FrameArena;
+
+/*
+====================================================
+BoundsSoA
+Bounds packed as a structure of arrays, so that overlaps
+can be tested 4 (SSE) or 8 (AVX) boxes at a time.
+The six lanes are one block, either owned and kept from one
+Resize to the next, or taken from the arena of the step.
+====================================================
+*/
+class BoundsSoA {
+public:
+	BoundsSoA() {}
+	BoundsSoA( const BoundsSoA & rhs ) = delete;
+	BoundsSoA & operator = ( const BoundsSoA & rhs ) = delete;
+
+	// The contents are lost on either Resize
+	void Resize( const int num );
+	// The lanes live until the arena is reset
+	void Resize( const int num, FrameArena & arena );
+	void Set( const int idx, const Bounds & bounds );
+	int Size() const { return numBounds; }
+
+	bool Overlaps( const int a, const int b ) const;
+
+	// Writes the indices in [first, last) whose box overlaps box idx, returns how many
+	int OverlapRun( const int idx, const int first, const int last, int * overlapping ) const;
+
+	// Keeps the pairs whose boxes overlap on all three axes, returns how many
+	int FilterPairs( const CollisionPair * pairs, const int num, CollisionPair * kept ) const;
+
+public:
+	float * minX = nullptr;
+	float * minY = nullptr;
+	float * minZ = nullptr;
+	float * maxX = nullptr;
+	float * maxY = nullptr;
+	float * maxZ = nullptr;
+
+private:
+	void SetLanes( float * lanes, const int num );
+
+	std::vector< float > storage;
+	int numBounds = 0;
+};
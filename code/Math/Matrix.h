@@ -79,6 +79,8 @@ public:
 	float Determinant() const;
 	Mat3 Transpose() const;
 	Mat3 Inverse() const;
+	Mat3 InverseSymmetric() const;	// reads the upper triangle only
+	Mat3 InverseDiagonal() const;	// reads the diagonal only
 	Mat2 Minor( const int i, const int j ) const;
 	float Cofactor( const int i, const int j ) const;
 
@@ -90,7 +92,11 @@ public:
 	const Mat3 & operator += ( const Mat3 & rhs );
 
 public:
+#if defined( MATH_SIMD )
+	Vec3A rows[ 3 ];	// one SIMD register per row
+#else
 	Vec3 rows[ 3 ];
+#endif
 };
 
 inline Mat3::Mat3( const Mat3 & rhs ) {
@@ -159,6 +165,18 @@ inline float Mat3::Determinant() const {
 }
 
 inline Mat3 Mat3::Transpose() const {
+#if defined( MATH_SIMD )
+	__m128 row0 = rows[ 0 ].Load();
+	__m128 row1 = rows[ 1 ].Load();
+	__m128 row2 = rows[ 2 ].Load();
+	__m128 row3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS( row0, row1, row2, row3 );
+	Mat3 transpose;
+	transpose.rows[ 0 ] = Vec3A( row0 );
+	transpose.rows[ 1 ] = Vec3A( row1 );
+	transpose.rows[ 2 ] = Vec3A( row2 );
+	return transpose;
+#else
 	Mat3 transpose;
 	for ( int i = 0; i < 3; i++ ) {
 		for ( int j = 0; j < 3; j++ ) {
@@ -166,18 +184,57 @@ inline Mat3 Mat3::Transpose() const {
 		}
 	}
 	return transpose;
+#endif
 }
 
 inline Mat3 Mat3::Inverse() const {
+	// The cofactors of a row are the cross product of the other two rows,
+	// and they make up a column of the inverse
+	const Vec3 a = rows[ 0 ];
+	const Vec3 b = rows[ 1 ];
+	const Vec3 c = rows[ 2 ];
+	const Vec3 bc = b.Cross( c );
+	const Vec3 ca = c.Cross( a );
+	const Vec3 ab = a.Cross( b );
+	const float invDet = 1.0f / a.Dot( bc );
+
 	Mat3 inv;
-	for ( int i = 0; i < 3; i++ ) {
-		for ( int j = 0; j < 3; j++ ) {
-			inv.rows[ j ][ i ] = Cofactor( i, j );	// Perform the transpose while calculating the cofactors
-		}
-	}
-	float det = Determinant();
-	float invDet = 1.0f / det;
-	inv *= invDet;
+	inv.rows[ 0 ] = Vec3( bc.x, ca.x, ab.x ) * invDet;
+	inv.rows[ 1 ] = Vec3( bc.y, ca.y, ab.y ) * invDet;
+	inv.rows[ 2 ] = Vec3( bc.z, ca.z, ab.z ) * invDet;
+	return inv;
+}
+
+inline Mat3 Mat3::InverseSymmetric() const {
+	// Inertia tensors are symmetric, so is their inverse: six cofactors instead of nine
+	const float xx = rows[ 0 ][ 0 ];
+	const float xy = rows[ 0 ][ 1 ];
+	const float xz = rows[ 0 ][ 2 ];
+	const float yy = rows[ 1 ][ 1 ];
+	const float yz = rows[ 1 ][ 2 ];
+	const float zz = rows[ 2 ][ 2 ];
+
+	const float cxx = yy * zz - yz * yz;
+	const float cxy = xz * yz - xy * zz;
+	const float cxz = xy * yz - xz * yy;
+	const float cyy = xx * zz - xz * xz;
+	const float cyz = xy * xz - xx * yz;
+	const float czz = xx * yy - xy * xy;
+	const float invDet = 1.0f / ( xx * cxx + xy * cxy + xz * cxz );
+
+	Mat3 inv;
+	inv.rows[ 0 ] = Vec3( cxx, cxy, cxz ) * invDet;
+	inv.rows[ 1 ] = Vec3( cxy, cyy, cyz ) * invDet;
+	inv.rows[ 2 ] = Vec3( cxz, cyz, czz ) * invDet;
+	return inv;
+}
+
+inline Mat3 Mat3::InverseDiagonal() const {
+	Mat3 inv;
+	inv.Zero();
+	inv.rows[ 0 ][ 0 ] = 1.0f / rows[ 0 ][ 0 ];
+	inv.rows[ 1 ][ 1 ] = 1.0f / rows[ 1 ][ 1 ];
+	inv.rows[ 2 ][ 2 ] = 1.0f / rows[ 2 ][ 2 ];
 	return inv;
 }
 
@@ -212,11 +269,22 @@ inline float Mat3::Cofactor( const int i, const int j ) const {
 }
 
 inline Vec3 Mat3::operator * ( const Vec3 & rhs ) const {
+#if defined( MATH_SIMD )
+	// The row products summed across, two horizontal adds give x, y, z, 0
+	const __m128 v = SimdLoad3( &rhs.x );
+	const __m128 x = _mm_mul_ps( rows[ 0 ].Load(), v );
+	const __m128 y = _mm_mul_ps( rows[ 1 ].Load(), v );
+	const __m128 z = _mm_mul_ps( rows[ 2 ].Load(), v );
+	Vec3 tmp;
+	SimdStore3( &tmp.x, _mm_hadd_ps( _mm_hadd_ps( x, y ), _mm_hadd_ps( z, _mm_setzero_ps() ) ) );
+	return tmp;
+#else
 	Vec3 tmp;
 	tmp[ 0 ] = rows[ 0 ].Dot( rhs );
 	tmp[ 1 ] = rows[ 1 ].Dot( rhs );
 	tmp[ 2 ] = rows[ 2 ].Dot( rhs );
 	return tmp;
+#endif
 }
 
 inline Mat3 Mat3::operator * ( const float rhs ) const {
@@ -228,6 +296,21 @@ inline Mat3 Mat3::operator * ( const float rhs ) const {
 }
 
 inline Mat3 Mat3::operator * ( const Mat3 & rhs ) const {
+#if defined( MATH_SIMD )
+	const __m128 rhs0 = rhs.rows[ 0 ].Load();
+	const __m128 rhs1 = rhs.rows[ 1 ].Load();
+	const __m128 rhs2 = rhs.rows[ 2 ].Load();
+	Mat3 tmp;
+	for ( int i = 0; i < 3; i++ ) {
+		// Row i is a combination of the rows of rhs
+		const __m128 row = rows[ i ].Load();
+		__m128 sum = _mm_mul_ps( MATH_SHUFFLE( row, 0, 0, 0, 0 ), rhs0 );
+		sum = _mm_add_ps( sum, _mm_mul_ps( MATH_SHUFFLE( row, 1, 1, 1, 1 ), rhs1 ) );
+		sum = _mm_add_ps( sum, _mm_mul_ps( MATH_SHUFFLE( row, 2, 2, 2, 2 ), rhs2 ) );
+		tmp.rows[ i ] = Vec3A( sum );
+	}
+	return tmp;
+#else
 	Mat3 tmp;
 	for ( int i = 0; i < 3; i++ ) {
 		tmp.rows[ i ].x = rows[ i ].x * rhs.rows[ 0 ].x + rows[ i ].y * rhs.rows[ 1 ].x + rows[ i ].z * rhs.rows[ 2 ].x;
@@ -235,6 +318,7 @@ inline Mat3 Mat3::operator * ( const Mat3 & rhs ) const {
 		tmp.rows[ i ].z = rows[ i ].x * rhs.rows[ 0 ].z + rows[ i ].y * rhs.rows[ 1 ].z + rows[ i ].z * rhs.rows[ 2 ].z;
 	}
 	return tmp;
+#endif
 }
 
 inline Mat3 Mat3::operator + ( const Mat3 & rhs ) const {
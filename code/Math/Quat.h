@@ -10,7 +10,7 @@
  Quat
  ================================
  */
-class Quat {
+class MATH_ALIGN16 Quat {
 public:
 	Quat();	
 	Quat( const Quat & rhs );
@@ -35,6 +35,11 @@ public:
 	Mat3	ToMat3() const;
 	Vec4	ToVec4() const { return Vec4( w, x, y, z ); }
 
+#if defined( MATH_SIMD )
+	Quat( const __m128 v ) { _mm_store_ps( &w, v ); }
+	__m128	Load() const { return _mm_load_ps( &w ); }
+#endif
+
 public:
 	float w;
 	float x;
@@ -101,12 +106,26 @@ inline Quat & Quat::operator *= ( const Quat & rhs ) {
 }
 
 inline Quat Quat::operator * ( const Quat & rhs ) const {
+#if defined( MATH_SIMD )
+	// Lanes are w, x, y, z. Each component of this scales a swizzle of rhs.
+	const __m128 a = Load();
+	const __m128 b = rhs.Load();
+	const __m128 signX = _mm_castsi128_ps( _mm_set_epi32( 0, (int)0x80000000, 0, (int)0x80000000 ) );
+	const __m128 signY = _mm_castsi128_ps( _mm_set_epi32( (int)0x80000000, 0, 0, (int)0x80000000 ) );
+	const __m128 signZ = _mm_castsi128_ps( _mm_set_epi32( 0, 0, (int)0x80000000, (int)0x80000000 ) );
+	__m128 sum = _mm_mul_ps( MATH_SHUFFLE( a, 0, 0, 0, 0 ), b );
+	sum = _mm_add_ps( sum, _mm_xor_ps( _mm_mul_ps( MATH_SHUFFLE( a, 1, 1, 1, 1 ), MATH_SHUFFLE( b, 1, 0, 3, 2 ) ), signX ) );
+	sum = _mm_add_ps( sum, _mm_xor_ps( _mm_mul_ps( MATH_SHUFFLE( a, 2, 2, 2, 2 ), MATH_SHUFFLE( b, 2, 3, 0, 1 ) ), signY ) );
+	sum = _mm_add_ps( sum, _mm_xor_ps( _mm_mul_ps( MATH_SHUFFLE( a, 3, 3, 3, 3 ), MATH_SHUFFLE( b, 3, 2, 1, 0 ) ), signZ ) );
+	return Quat( sum );
+#else
 	Quat temp;	
 	temp.w = ( w * rhs.w ) - ( x * rhs.x ) - ( y * rhs.y ) - ( z * rhs.z );
 	temp.x = ( x * rhs.w ) + ( w * rhs.x ) + ( y * rhs.z ) - ( z * rhs.y );
 	temp.y = ( y * rhs.w ) + ( w * rhs.y ) + ( z * rhs.x ) - ( x * rhs.z );
 	temp.z = ( z * rhs.w ) + ( w * rhs.z ) + ( x * rhs.y ) - ( y * rhs.x );
 	return temp;
+#endif
 }
 
 inline void Quat::Normalize() {
@@ -134,7 +153,11 @@ inline Quat Quat::Inverse() const {
 }
 
 inline float Quat::MagnitudeSquared() const {
+#if defined( MATH_SIMD )
+    return SimdDot4( Load(), Load() );
+#else
     return ( ( x * x ) + ( y * y ) + ( z * z ) + ( w * w ) );
+#endif
 }
 
 inline float Quat::GetMagnitude() const {
@@ -142,9 +165,26 @@ inline float Quat::GetMagnitude() const {
 }
 
 inline Vec3 Quat::RotatePoint( const Vec3 & rhs ) const {
+#if defined( MATH_SIMD )
+	// q v q^-1 expanded, with u the vector part of q:
+	// ( ( w^2 - u.u ) v + 2 ( u.v ) u + 2 w ( u x v ) ) / |q|^2
+	const __m128 q = Load();
+	const __m128 u = _mm_blend_ps( MATH_SHUFFLE( q, 1, 2, 3, 0 ), _mm_setzero_ps(), 8 );
+	const __m128 v = SimdLoad3( &rhs.x );
+	const __m128 ww = _mm_mul_ps( MATH_SHUFFLE( q, 0, 0, 0, 0 ), MATH_SHUFFLE( q, 0, 0, 0, 0 ) );
+	const __m128 uu = SimdDot3( u, u );
+	const __m128 two = _mm_set1_ps( 2.0f );
+	__m128 result = _mm_mul_ps( _mm_sub_ps( ww, uu ), v );
+	result = _mm_add_ps( result, _mm_mul_ps( _mm_mul_ps( two, SimdDot3( u, v ) ), u ) );
+	result = _mm_add_ps( result, _mm_mul_ps( _mm_mul_ps( two, MATH_SHUFFLE( q, 0, 0, 0, 0 ) ), SimdCross3( u, v ) ) );
+	Vec3 point;
+	SimdStore3( &point.x, _mm_div_ps( result, _mm_add_ps( ww, uu ) ) );
+	return point;
+#else
 	Quat vector( rhs.x, rhs.y, rhs.z, 0.0f );
 	Quat final = *this * vector * Inverse();
 	return Vec3( final.x, final.y, final.z );
+#endif
 }
 
 inline bool Quat::IsValid() const {
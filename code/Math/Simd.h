@@ -0,0 +1,62 @@
+//
+//	Simd.h
+//
+#pragma once
+
+/*
+====================================================
+SIMD backend of the math types
+Opt-in with PHYSICS_SIMD_MATH, it needs SSE4.1 (blends)
+or AVX. Without it every type stays on its scalar code. The
+public API is the same either way, only the layouts change:
+Vec4 and Quat become 16 byte aligned and the rows of a Mat3
+become Vec3A, so a Mat3 is no longer nine packed floats.
+====================================================
+*/
+#if defined( PHYSICS_SIMD_MATH ) && ( defined( __SSE4_1__ ) || defined( __AVX__ ) )
+#include <smmintrin.h>
+#define MATH_SIMD
+#define MATH_ALIGN16 alignas( 16 )
+#else
+#define MATH_ALIGN16
+#endif
+
+#if defined( MATH_SIMD )
+#define MATH_SHUFFLE( v, x, y, z, w ) _mm_shuffle_ps( v, v, _MM_SHUFFLE( w, z, y, x ) )
+
+// Three packed floats, such as a Vec3, to and from a register with a zero w.
+// Filling a Vec3A float by float and loading it stalls on store forwarding.
+inline __m128 SimdLoad3( const float * xyz ) {
+	const __m128 xy = _mm_castpd_ps( _mm_load_sd( reinterpret_cast< const double * >( xyz ) ) );
+	return _mm_movelh_ps( xy, _mm_load_ss( xyz + 2 ) );
+}
+
+inline void SimdStore3( float * xyz, const __m128 v ) {
+	_mm_store_sd( reinterpret_cast< double * >( xyz ), _mm_castps_pd( v ) );
+	_mm_store_ss( xyz + 2, _mm_movehl_ps( v, v ) );
+}
+
+// Sum of the products of the first three lanes, in every lane.
+// Shuffles and adds, dpps is slower on most cores.
+inline __m128 SimdDot3( const __m128 a, const __m128 b ) {
+	const __m128 products = _mm_mul_ps( a, b );
+	const __m128 xy = _mm_add_ss( products, MATH_SHUFFLE( products, 1, 1, 1, 1 ) );
+	const __m128 xyz = _mm_add_ss( xy, _mm_movehl_ps( products, products ) );
+	return MATH_SHUFFLE( xyz, 0, 0, 0, 0 );
+}
+
+// Sum of the products of all four lanes
+inline float SimdDot4( const __m128 a, const __m128 b ) {
+	const __m128 products = _mm_mul_ps( a, b );
+	const __m128 pairs = _mm_add_ps( products, _mm_movehl_ps( products, products ) );
+	return _mm_cvtss_f32( _mm_add_ss( pairs, MATH_SHUFFLE( pairs, 1, 1, 1, 1 ) ) );
+}
+
+inline __m128 SimdCross3( const __m128 a, const __m128 b ) {
+	const __m128 aYZX = MATH_SHUFFLE( a, 1, 2, 0, 3 );
+	const __m128 bYZX = MATH_SHUFFLE( b, 1, 2, 0, 3 );
+	const __m128 aZXY = MATH_SHUFFLE( a, 2, 0, 1, 3 );
+	const __m128 bZXY = MATH_SHUFFLE( b, 2, 0, 1, 3 );
+	return _mm_sub_ps( _mm_mul_ps( aYZX, bZXY ), _mm_mul_ps( bYZX, aZXY ) );
+}
+#endif
@@ -5,6 +5,7 @@
 #include <math.h>
 #include <assert.h>
 #include <stdio.h>
+#include "Simd.h"
 
 /*
  ================================
@@ -437,12 +438,219 @@ inline void Vec3::GetOrtho( Vec3 & u, Vec3 & v ) const {
 	u.Normalize();
 }
 
+/*
+ ================================
+ Vec3A
+ Vec3 padded to 16 bytes and aligned, so that it loads into a
+ single SIMD register. w is padding and stays zero. Converts to
+ and from Vec3 implicitly, the rows of a SIMD Mat3 are Vec3A.
+ ================================
+ */
+class alignas( 16 ) Vec3A {
+public:
+	Vec3A();
+	Vec3A( float value );
+	Vec3A( float X, float Y, float Z );
+	Vec3A( const Vec3 & rhs );
+	Vec3A( const float * xyz );
+	Vec3A & operator = ( const float * rhs );
+	operator Vec3() const { return Vec3( x, y, z ); }
+
+	bool			operator == ( const Vec3A & rhs ) const;
+	bool			operator != ( const Vec3A & rhs ) const;
+	Vec3A			operator + ( const Vec3A & rhs ) const;
+	const Vec3A &	operator += ( const Vec3A & rhs );
+	const Vec3A &	operator -= ( const Vec3A & rhs );
+	Vec3A			operator - ( const Vec3A & rhs ) const;
+	Vec3A			operator * ( const float rhs ) const;
+	Vec3A			operator / ( const float rhs ) const;
+	const Vec3A &	operator *= ( const float rhs );
+	const Vec3A &	operator /= ( const float rhs );
+	float			operator [] ( const int idx ) const;
+	float &			operator [] ( const int idx );
+
+	void Zero() { x = 0.0f; y = 0.0f; z = 0.0f; w = 0.0f; }
+
+	Vec3A Cross( const Vec3A & rhs ) const;
+	float Dot( const Vec3A & rhs ) const;
+
+	const Vec3A & Normalize();
+	float GetMagnitude() const;
+	float GetLengthSqr() const { return Dot( *this ); }
+	bool IsValid() const { return Vec3( x, y, z ).IsValid(); }
+
+	const float * ToPtr() const { return &x; }
+
+#if defined( MATH_SIMD )
+	Vec3A( const __m128 v ) { _mm_store_ps( &x, v ); }
+	__m128 Load() const { return _mm_load_ps( &x ); }
+#endif
+
+public:
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+inline Vec3A::Vec3A() :
+x( 0 ),
+y( 0 ),
+z( 0 ),
+w( 0 ) {
+}
+
+inline Vec3A::Vec3A( float value ) :
+x( value ),
+y( value ),
+z( value ),
+w( 0 ) {
+}
+
+inline Vec3A::Vec3A( float X, float Y, float Z ) :
+x( X ),
+y( Y ),
+z( Z ),
+w( 0 ) {
+}
+
+inline Vec3A::Vec3A( const Vec3 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, SimdLoad3( &rhs.x ) );
+#else
+	x = rhs.x;
+	y = rhs.y;
+	z = rhs.z;
+	w = 0.0f;
+#endif
+}
+
+inline Vec3A::Vec3A( const float * xyz ) :
+x( xyz[ 0 ] ),
+y( xyz[ 1 ] ),
+z( xyz[ 2 ] ),
+w( 0 ) {
+}
+
+inline Vec3A & Vec3A::operator = ( const float * rhs ) {
+	x = rhs[ 0 ];
+	y = rhs[ 1 ];
+	z = rhs[ 2 ];
+	w = 0.0f;
+	return *this;
+}
+
+inline bool Vec3A::operator == ( const Vec3A & rhs ) const {
+#if defined( MATH_SIMD )
+	return ( _mm_movemask_ps( _mm_cmpeq_ps( Load(), rhs.Load() ) ) & 7 ) == 7;
+#else
+	return x == rhs.x && y == rhs.y && z == rhs.z;
+#endif
+}
+
+inline bool Vec3A::operator != ( const Vec3A & rhs ) const {
+	return !( *this == rhs );
+}
+
+inline Vec3A Vec3A::operator + ( const Vec3A & rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec3A( _mm_add_ps( Load(), rhs.Load() ) );
+#else
+	return Vec3A( x + rhs.x, y + rhs.y, z + rhs.z );
+#endif
+}
+
+inline const Vec3A & Vec3A::operator += ( const Vec3A & rhs ) {
+	*this = *this + rhs;
+	return *this;
+}
+
+inline const Vec3A & Vec3A::operator -= ( const Vec3A & rhs ) {
+	*this = *this - rhs;
+	return *this;
+}
+
+inline Vec3A Vec3A::operator - ( const Vec3A & rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec3A( _mm_sub_ps( Load(), rhs.Load() ) );
+#else
+	return Vec3A( x - rhs.x, y - rhs.y, z - rhs.z );
+#endif
+}
+
+inline Vec3A Vec3A::operator * ( const float rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec3A( _mm_mul_ps( Load(), _mm_set1_ps( rhs ) ) );
+#else
+	return Vec3A( x * rhs, y * rhs, z * rhs );
+#endif
+}
+
+inline Vec3A Vec3A::operator / ( const float rhs ) const {
+#if defined( MATH_SIMD )
+	// Keeps w at zero, dividing it would give NaN for a zero rhs
+	const __m128 v = _mm_div_ps( Load(), _mm_set1_ps( rhs ) );
+	return Vec3A( _mm_blend_ps( v, _mm_setzero_ps(), 8 ) );
+#else
+	return Vec3A( x / rhs, y / rhs, z / rhs );
+#endif
+}
+
+inline const Vec3A & Vec3A::operator *= ( const float rhs ) {
+	*this = *this * rhs;
+	return *this;
+}
+
+inline const Vec3A & Vec3A::operator /= ( const float rhs ) {
+	*this = *this / rhs;
+	return *this;
+}
+
+inline float Vec3A::operator [] ( const int idx ) const {
+	assert( idx >= 0 && idx < 3 );
+	return ( &x )[ idx ];
+}
+
+inline float & Vec3A::operator [] ( const int idx ) {
+	assert( idx >= 0 && idx < 3 );
+	return ( &x )[ idx ];
+}
+
+inline Vec3A Vec3A::Cross( const Vec3A & rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec3A( SimdCross3( Load(), rhs.Load() ) );
+#else
+	return Vec3( x, y, z ).Cross( Vec3( rhs.x, rhs.y, rhs.z ) );
+#endif
+}
+
+inline float Vec3A::Dot( const Vec3A & rhs ) const {
+#if defined( MATH_SIMD )
+	return _mm_cvtss_f32( SimdDot3( Load(), rhs.Load() ) );
+#else
+	return ( x * rhs.x ) + ( y * rhs.y ) + ( z * rhs.z );
+#endif
+}
+
+inline const Vec3A & Vec3A::Normalize() {
+	float mag = GetMagnitude();
+	float invMag = 1.0f / mag;
+	if ( 0.0f * invMag == 0.0f * invMag ) {
+		*this *= invMag;
+	}
+	return *this;
+}
+
+inline float Vec3A::GetMagnitude() const {
+	return sqrtf( Dot( *this ) );
+}
+
 /*
  ================================
  Vec4
  ================================
  */
-class Vec4 {
+class MATH_ALIGN16 Vec4 {
 public:
 	Vec4();
 	Vec4( const float value );
@@ -471,6 +679,11 @@ public:
 	
     const float *   ToPtr() const   { return &x; }
 	float *         ToPtr()         { return &x; }
+
+#if defined( MATH_SIMD )
+	Vec4( const __m128 v ) { _mm_store_ps( &x, v ); }
+	__m128 Load() const { return _mm_load_ps( &x ); }
+#endif
 	
 public:
 	float x;
@@ -551,62 +764,94 @@ inline bool Vec4::operator != ( const Vec4 & rhs ) const {
 }
 
 inline Vec4 Vec4::operator + ( const Vec4 & rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec4( _mm_add_ps( Load(), rhs.Load() ) );
+#else
 	Vec4 temp;
 	temp.x = x + rhs.x;
 	temp.y = y + rhs.y;
 	temp.z = z + rhs.z;
 	temp.w = w + rhs.w;
 	return temp;
+#endif
 }
 
 inline const Vec4 & Vec4::operator += ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_add_ps( Load(), rhs.Load() ) );
+	return *this;
+#else
 	x += rhs.x;
 	y += rhs.y;
 	z += rhs.z;
 	w += rhs.w;
 	return *this;
+#endif
 }
 
 inline const Vec4 & Vec4::operator -= ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_sub_ps( Load(), rhs.Load() ) );
+	return *this;
+#else
 	x -= rhs.x;
 	y -= rhs.y;
 	z -= rhs.z;
 	w -= rhs.w;
 	return *this;
+#endif
 }
 
 inline const Vec4 & Vec4::operator *= ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_mul_ps( Load(), rhs.Load() ) );
+	return *this;
+#else
 	x *= rhs.x;
 	y *= rhs.y;
 	z *= rhs.z;
 	w *= rhs.w;
 	return *this;
+#endif
 }
 
 inline const Vec4 & Vec4::operator /= ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_div_ps( Load(), rhs.Load() ) );
+	return *this;
+#else
 	x /= rhs.x;
 	y /= rhs.y;
 	z /= rhs.z;
 	w /= rhs.w;
 	return *this;
+#endif
 }
 
 inline Vec4 Vec4::operator - ( const Vec4 & rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec4( _mm_sub_ps( Load(), rhs.Load() ) );
+#else
 	Vec4 temp;
 	temp.x = x - rhs.x;
 	temp.y = y - rhs.y;
 	temp.z = z - rhs.z;
 	temp.w = w - rhs.w;
 	return temp;
+#endif
 }
 
 inline Vec4 Vec4::operator * ( const float rhs ) const {
+#if defined( MATH_SIMD )
+	return Vec4( _mm_mul_ps( Load(), _mm_set1_ps( rhs ) ) );
+#else
 	Vec4 temp;
 	temp.x = x * rhs;
 	temp.y = y * rhs;
 	temp.z = z * rhs;
 	temp.w = w * rhs;
 	return temp;
+#endif
 }
 
 inline float Vec4::operator [] ( const int idx ) const {
@@ -620,11 +865,15 @@ inline float& Vec4::operator [] ( const int idx ) {
 }
 
 inline float Vec4::Dot( const Vec4 & rhs ) const {
+#if defined( MATH_SIMD )
+	return SimdDot4( Load(), rhs.Load() );
+#else
 	float xx = x * rhs.x;
 	float yy = y * rhs.y;
 	float zz = z * rhs.z;
 	float ww = w * rhs.w;
 	return ( xx + yy + zz + ww );
+#endif
 }
 
 inline const Vec4 & Vec4::Normalize() {
@@ -0,0 +1,100 @@
+#include "Narrowphase.h"
+#include "Intersections.h"
+#include "JobSystem.h"
+
+// Below this a single thread is done before the workers would wake up
+static const int MIN_PAIRS_PER_BLOCK = 256;
+
+// Solves the batched sphere pairs and appends their contacts
+static int FlushSphereBatch(SphereSphereBatch& batch, const int* batchPairs, const std::vector<Body*>& bodies, const std::vector<CollisionPair>& pairs, const float dt_sec, Contact* contacts, int* contactPairs)
+{
+	int hits[SphereSphereBatch::MAX_PAIRS];
+	const int numHits = Intersections::SphereSphereDynamicBatch(batch, dt_sec, hits);
+	for (int i = 0; i < numHits; i++) {
+		const int lane = hits[i];
+		const CollisionPair& pair = pairs[batchPairs[lane]];
+		Body& bodyA = *bodies[pair.a];
+		Body& bodyB = *bodies[pair.b];
+		Contact& contact = contacts[i];
+		contact.a = &bodyA;
+		contact.b = &bodyB;
+		contact.timeOfImpact = batch.timeOfImpact[lane];
+		contact.ptOnAWorldSpace = Vec3(batch.ptOnAX[lane], batch.ptOnAY[lane], batch.ptOnAZ[lane]);
+		contact.ptOnBWorldSpace = Vec3(batch.ptOnBX[lane], batch.ptOnBY[lane], batch.ptOnBZ[lane]);
+		Intersections::FinishSphereSphereContact(bodyA, bodyB, contact);
+		contactPairs[i] = batchPairs[lane];
+	}
+	batch.Clear();
+	return numHits;
+}
+
+int NarrowPhase(const std::vector<Body*>& bodies, const std::vector<CollisionPair>& pairs, const float dt_sec, Contact* contacts, int* contactPairs, const bool useBatches)
+{
+	const int numPairs = (int)pairs.size();
+	JobSystem& jobs = JobSystem::Get();
+	// A few blocks per thread, the cost of a pair varies a lot
+	// between a quick miss and a full time of impact
+	int numBlocks = jobs.GetNumThreads() * 4;
+	if (numBlocks > numPairs / MIN_PAIRS_PER_BLOCK) {
+		numBlocks = numPairs / MIN_PAIRS_PER_BLOCK;
+	}
+	if (numBlocks < 1) {
+		numBlocks = 1;
+	}
+	const int blockSize = (numPairs + numBlocks - 1) / numBlocks;
+
+	std::vector<int> blockCounts(numBlocks);
+	jobs.ParallelFor(numBlocks, [&](int block) {
+		const int first = block * blockSize;
+		const int last = (first + blockSize < numPairs) ? first + blockSize : numPairs;
+		SphereSphereBatch batch;
+		int batchPairs[SphereSphereBatch::MAX_PAIRS];
+		int count = 0;
+		for (int i = first; i < last; i++) {
+			const CollisionPair& pair = pairs[i];
+			Body& bodyA = *bodies[pair.a];
+			Body& bodyB = *bodies[pair.b];
+			if (bodyA.inverseMass == 0.0f && bodyB.inverseMass == 0.0f) {
+				continue;
+			}
+			if (useBatches
+			&& bodyA.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE
+			&& bodyB.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE) {
+				batchPairs[batch.num] = i;
+				batch.Add(bodyA, bodyB);
+				if (batch.IsFull()) {
+					count += FlushSphereBatch(batch, batchPairs, bodies, pairs, dt_sec, contacts + first + count, contactPairs + first + count);
+				}
+				continue;
+			}
+			// Keep the contacts in pair order
+			if (batch.num > 0) {
+				count += FlushSphereBatch(batch, batchPairs, bodies, pairs, dt_sec, contacts + first + count, contactPairs + first + count);
+			}
+			// The test only reads the bodies, blocks sharing a body do not race
+			Contact& contact = contacts[first + count];
+			if (Intersections::FindContact(bodyA, bodyB, dt_sec, contact)) {
+				contact.a = &bodyA;
+				contact.b = &bodyB;
+				contactPairs[first + count] = i;
+				++count;
+			}
+		}
+		if (batch.num > 0) {
+			count += FlushSphereBatch(batch, batchPairs, bodies, pairs, dt_sec, contacts + first + count, contactPairs + first + count);
+		}
+		blockCounts[block] = count;
+	});
+
+	// Merge the slices, each one only moves towards the front
+	int numContacts = blockCounts[0];
+	for (int block = 1; block < numBlocks; block++) {
+		const int first = block * blockSize;
+		for (int i = 0; i < blockCounts[block]; i++) {
+			contacts[numContacts] = contacts[first + i];
+			contactPairs[numContacts] = contactPairs[first + i];
+			++numContacts;
+		}
+	}
+	return numContacts;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <vector>
+#include "Broadphase.h"
+#include "Contact.h"
+
+// Tests every broadphase pair for a contact within the step. The pairs are
+// split into blocks run on the JobSystem, each block writes the contacts it
+// finds to its own slice of the buffer, then the slices are packed in block
+// order so the contacts come out in pair order for any number of threads.
+// contacts and contactPairs need room for one entry per pair, contactPairs
+// gets the index of the pair behind each contact. Returns the contact count.
+// Sphere pairs are solved in SIMD batches unless useBatches is false, which
+// keeps the one pair at a time path around to check the batches against.
+int NarrowPhase(const std::vector<Body*>& bodies, const std::vector<CollisionPair>& pairs, const float dt_sec, Contact* contacts, int* contactPairs, const bool useBatches = true);
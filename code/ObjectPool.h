@@ -0,0 +1,107 @@
+#pragma once
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed size blocks for objects of one type, allocated a chunk at a time and
+// never given back to the heap until the pool goes away. Acquire and Release
+// push and pop a free list, ReleaseAll destroys every live object at once and
+// keeps the chunks, so a scene that is reset over and over holds flat memory.
+template<typename T>
+class ObjectPool
+{
+public:
+	explicit ObjectPool(const int blocksPerChunk = 64) : blocksPerChunk(blocksPerChunk) {}
+	~ObjectPool()
+	{
+		ReleaseAll();
+		for (Block* chunk : chunks) {
+			delete[] chunk;
+		}
+	}
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	template<typename... Args>
+	T* Acquire(Args&&... args)
+	{
+		if (freeList == nullptr) {
+			AddChunk();
+		}
+		Block* block = freeList;
+		freeList = block->next;
+		block->isLive = true;
+		++numLive;
+		return new (block->storage) T(std::forward<Args>(args)...);
+	}
+
+	// The object must come from this pool
+	void Release(T* object)
+	{
+		object->~T();
+		Block* block = reinterpret_cast<Block*>(object);
+		block->isLive = false;
+		block->next = freeList;
+		freeList = block;
+		--numLive;
+	}
+
+	void ReleaseAll()
+	{
+		// Rebuilt back to front so that the next objects fill the first chunk in order
+		freeList = nullptr;
+		for (int c = (int)chunks.size() - 1; c >= 0; c--) {
+			for (int i = blocksPerChunk - 1; i >= 0; i--) {
+				Block& block = chunks[c][i];
+				if (block.isLive) {
+					reinterpret_cast<T*>(block.storage)->~T();
+					block.isLive = false;
+				}
+				block.next = freeList;
+				freeList = &block;
+			}
+		}
+		numLive = 0;
+	}
+
+	// Takes any pointer so that a base class pointer may be tested
+	bool Owns(const void* object) const
+	{
+		const Block* block = static_cast<const Block*>(object);
+		for (const Block* chunk : chunks) {
+			if (block >= chunk && block < chunk + blocksPerChunk) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int GetNumLive() const { return numLive; }
+	int GetCapacity() const { return (int)chunks.size() * blocksPerChunk; }
+
+private:
+	// The object comes first so that its address is the address of its block
+	struct Block
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+		Block* next;
+		bool isLive;
+	};
+
+	void AddChunk()
+	{
+		Block* chunk = new Block[blocksPerChunk];
+		for (int i = blocksPerChunk - 1; i >= 0; i--) {
+			chunk[i].isLive = false;
+			chunk[i].next = freeList;
+			freeList = &chunk[i];
+		}
+		chunks.push_back(chunk);
+	}
+
+	int blocksPerChunk;
+	std::vector<Block*> chunks;
+	Block* freeList = nullptr;
+	int numLive = 0;
+};
@@ -0,0 +1,123 @@
+#include "RadixSort.h"
+#include "Broadphase.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+
+#include <string.h>
+
+namespace
+{
+	const int RADIX_BITS = 8;
+	const int NUM_BUCKETS = 1 << RADIX_BITS;
+	const int NUM_PASSES = 32 / RADIX_BITS;
+
+	// Below this the thread hand-off costs more than the sort
+	const int MIN_PARALLEL_ENDPOINTS = 16 * 1024;
+	const int MIN_BLOCK_SIZE = 4 * 1024;
+
+	struct SortItem
+	{
+		uint32_t key;
+		PseudoBody endpoint;
+	};
+
+	inline int Digit(const uint32_t key, const int pass)
+	{
+		return (key >> (pass * RADIX_BITS)) & (NUM_BUCKETS - 1);
+	}
+}
+
+void RadixSortEndpoints(PseudoBody* endpoints, const int num, FrameArena* arena)
+{
+	if (num <= 1) {
+		return;
+	}
+
+	JobSystem& jobs = JobSystem::Get();
+	int numBlocks = 1;
+	if (num >= MIN_PARALLEL_ENDPOINTS) {
+		numBlocks = jobs.GetNumThreads();
+		if (numBlocks > num / MIN_BLOCK_SIZE) {
+			numBlocks = num / MIN_BLOCK_SIZE;
+		}
+	}
+	const int blockSize = (num + numBlocks - 1) / numBlocks;
+
+	std::vector<SortItem> heapItems;
+	SortItem* items = nullptr;
+	if (arena != nullptr) {
+		items = arena->Allocate<SortItem>(num * 2);
+	}
+	else {
+		heapItems.resize(num * 2);
+		items = heapItems.data();
+	}
+	for (int i = 0; i < num; i++) {
+		items[i].key = FloatToSortKey(endpoints[i].value);
+		items[i].endpoint = endpoints[i];
+	}
+
+	// One histogram per block, blocks write to their own rows only
+	std::vector<int> counts(numBlocks * NUM_BUCKETS);
+	SortItem* src = items;
+	SortItem* dst = items + num;
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		memset(counts.data(), 0, sizeof(int) * counts.size());
+		jobs.ParallelFor(numBlocks, [&](int block) {
+			int* blockCounts = &counts[block * NUM_BUCKETS];
+			const int first = block * blockSize;
+			const int last = (first + blockSize < num) ? first + blockSize : num;
+			for (int i = first; i < last; i++) {
+				++blockCounts[Digit(src[i].key, pass)];
+			}
+		});
+
+		// Every key has the same digit, this pass would copy the array as is
+		bool isTrivial = false;
+		for (int bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+			int total = 0;
+			for (int block = 0; block < numBlocks; block++) {
+				total += counts[block * NUM_BUCKETS + bucket];
+			}
+			if (total == num) {
+				isTrivial = true;
+				break;
+			}
+			if (total != 0) {
+				break;
+			}
+		}
+		if (isTrivial) {
+			continue;
+		}
+
+		// Turn the counts into offsets, bucket major then block, so block 0
+		// writes before block 1 inside each bucket and the sort stays stable
+		int offset = 0;
+		for (int bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+			for (int block = 0; block < numBlocks; block++) {
+				int& count = counts[block * NUM_BUCKETS + bucket];
+				const int blockCount = count;
+				count = offset;
+				offset += blockCount;
+			}
+		}
+
+		jobs.ParallelFor(numBlocks, [&](int block) {
+			int* blockOffsets = &counts[block * NUM_BUCKETS];
+			const int first = block * blockSize;
+			const int last = (first + blockSize < num) ? first + blockSize : num;
+			for (int i = first; i < last; i++) {
+				dst[blockOffsets[Digit(src[i].key, pass)]++] = src[i];
+			}
+		});
+
+		SortItem* temp = src;
+		src = dst;
+		dst = temp;
+	}
+
+	for (int i = 0; i < num; i++) {
+		endpoints[i] = src[i].endpoint;
+	}
+}
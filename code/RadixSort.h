@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+struct PseudoBody;
+class FrameArena;
+
+// Maps a float to an unsigned key with the same ordering
+inline uint32_t FloatToSortKey(const float value)
+{
+	union { float f; uint32_t u; } bits;
+	bits.f = value;
+	// Negative floats have every bit flipped so larger magnitudes come first,
+	// positive floats only get the sign bit set to sort after them
+	const uint32_t mask = (bits.u & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+	return bits.u ^ mask;
+}
+
+// Stable LSD radix sort of the endpoints by value, one byte per pass.
+// Endpoints with equal values keep their input order, so the result is the
+// same on every run and for any number of threads. Large arrays are split
+// into blocks that count and scatter in parallel on the JobSystem.
+// The scratch buffers come from the arena when one is given.
+void RadixSortEndpoints(PseudoBody* endpoints, const int num, FrameArena* arena = nullptr);
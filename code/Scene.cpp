@@ -1,25 +1,39 @@
 #include "Scene.h"
 #include "Shape.h"
-#include "Intersections.h"
+#include "Narrowphase.h"
 #include "Broadphase.h"
 #include "Player.h"
+#include "JobSystem.h"
 
 #include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <limits>
+#include <stdlib.h>
 
 Scene::~Scene() {
-	for ( int i = 0; i < bodies.size(); i++ ) {
-		delete bodies[ i ]->shape;
-	}
+	// The pools and the registry free the bodies and shapes
 	bodies.clear();
+	delete broadphase;
+	delete player1;
+	delete player2;
+}
+
+void Scene::SetBroadPhaseType(const BroadPhaseType type) {
+	delete broadphase;
+	broadphase = CreateBroadPhase(type);
+	broadphase->SetFrameArena(&frameArena);
 }
 
 void Scene::Reset() {
-	for ( int i = 0; i < bodies.size(); i++ ) {
-		if (bodies[i]->shape != nullptr) delete bodies[i]->shape;
-	}
+	// Bodies waiting to spawn go too, they come from the same pools
 	bodies.clear();
+	nextSpawnBodies.clear();
+	bodyPool.ReleaseAll();
+	ballPool.ReleaseAll();
+	shapes.Clear();
+	bodyStorage.Clear();
+	contactCache.Clear();
 
 	Initialize();
 }
@@ -27,14 +41,14 @@ void Scene::Reset() {
 void Scene::Initialize() {
 	
 	float radius = 500.0f;
-	earth = new Body();
+	earth = CreateBody();
 	earth->position = Vec3(0, 0, -radius);
 	earth->orientation = Quat(0, 0, 0, 1);
-	earth->shape = new ShapeSphere(radius);
+	earth->SetShape(CreateSphere(radius));
 	earth->inverseMass = 0.0f;
 	earth->elasticity = 0.2f;
 	earth->friction = 0.5f;
-	bodies.push_back(earth);
+	AddBody(earth);
 
 	if(player1 == nullptr) player1 = new Player(Name::Player1);
 	if(player2 == nullptr) player2 = new Player(Name::Player2);
@@ -46,9 +60,14 @@ void Scene::Initialize() {
 void Scene::Update(const float dt_sec)
 {
 	// Gravity
+	int numAwakeBodies = 0;
 	for (int i = 0; i < bodies.size(); ++i)
 	{
 		Body& body = *bodies[i];
+		if (body.inverseMass == 0.0f || !body.IsAwake()) {
+			continue;
+		}
+		++numAwakeBodies;
 		float mass = 1.0f / body.inverseMass;
 		// Gravity needs to be an impulse I
 		// I == dp, so F == dp/dt <=> dp = F * dt
@@ -64,63 +83,31 @@ void Scene::Update(const float dt_sec)
 		body.angularVelocity = Vec3::Lerp(body.angularVelocity, Vec3(0, 0, 0), 0.01f);
 	}
 	// Broadphase
-	std::vector<CollisionPair> collisionPairs;
-	BroadPhase(bodies, collisionPairs, dt_sec);
+	BroadPhase(*broadphase, bodies, collisionPairs, dt_sec);
 	// Collision checks (Narrow phase)
-	int numContacts = 0;
-	const int maxContacts = bodies.size() * bodies.size();
-	Contact* contacts = (Contact*)alloca(sizeof(Contact) * maxContacts);
-	for (int i = 0; i < collisionPairs.size(); ++i)
-	{
-		const CollisionPair& pair = collisionPairs[i];
-		Body& bodyA = *bodies[pair.a];
-		Body& bodyB = *bodies[pair.b];
-		if (bodyA.inverseMass == 0.0f && bodyB.inverseMass == 0.0f)
-			continue;
-		Contact contact;
-		if (Intersections::Intersect(bodyA, bodyB, dt_sec, contact))
-		{
-			contacts[numContacts] = contact;
-			++numContacts;
-			bodyA.linearVelocity = Vec3::Lerp(bodyA.linearVelocity, Vec3(0, 0, 0), 0.015);
-			bodyA.angularVelocity = Vec3::Lerp(bodyA.angularVelocity, Vec3(0, 0, 0), 0.015);
-			bodyB.linearVelocity = Vec3::Lerp(bodyB.linearVelocity, Vec3(0, 0, 0), 0.015);
-			bodyB.angularVelocity = Vec3::Lerp(bodyB.angularVelocity, Vec3(0, 0, 0), 0.015);
-		}
-	}
-	// Sort times of impact
-	if (numContacts > 1) {
-		qsort(contacts, numContacts, sizeof(Contact),
-		Contact::CompareContact);
-	}
-	// Contact resolve in order
-	
-	float accumulatedTime = 0.0f;
+	// Each pair yields at most one contact, so size the buffer on the pairs
+	// rather than bodies^2 on the stack (which overflows past a few hundred bodies)
+	Contact* contacts = frameArena.Allocate<Contact>((int)collisionPairs.size());
+	int* contactPairs = frameArena.Allocate<int>((int)collisionPairs.size());
+	const int numContacts = NarrowPhase(bodies, collisionPairs, dt_sec, contacts, contactPairs);
+	// Contact damping, once the whole narrow phase has seen the same velocities
 	for (int i = 0; i < numContacts; ++i)
 	{
-		Contact& contact = contacts[i];
-		const float dt = contact.timeOfImpact - accumulatedTime;
-		Body* bodyA = contact.a;
-		Body* bodyB = contact.b;
-		// Skip body par with infinite mass
-		if (bodyA->inverseMass == 0.0f && bodyB->inverseMass == 0.0f)
-			continue;
-		// Position update
-		for (int j = 0; j < bodies.size(); ++j) {
-			bodies[j]->Update(dt);
-		}
-		Contact::ResolveContact(contact);
-		accumulatedTime += dt;
-	}
-	// Other physics behavirous, outside collisions.
-	// Update the positions for the rest of this frame's time.
-	const float timeRemaining = dt_sec - accumulatedTime;
-	if (timeRemaining > 0.0f)
-	{
-		for (int i = 0; i < bodies.size(); ++i) {
-			bodies[i]->Update(timeRemaining);
-		}
+		Body& bodyA = *contacts[i].a;
+		Body& bodyB = *contacts[i].b;
+		bodyA.linearVelocity = Vec3::Lerp(bodyA.linearVelocity, Vec3(0, 0, 0), 0.015);
+		bodyA.angularVelocity = Vec3::Lerp(bodyA.angularVelocity, Vec3(0, 0, 0), 0.015);
+		bodyB.linearVelocity = Vec3::Lerp(bodyB.linearVelocity, Vec3(0, 0, 0), 0.015);
+		bodyB.angularVelocity = Vec3::Lerp(bodyB.angularVelocity, Vec3(0, 0, 0), 0.015);
 	}
+	lastStepStats.numBodies = (int)bodies.size();
+	lastStepStats.numAwakeBodies = numAwakeBodies;
+	lastStepStats.numPairs = (int)collisionPairs.size();
+	lastStepStats.numContacts = numContacts;
+	// Contact resolve in time of impact order, island by island
+	StepIslands(contacts, contactPairs, numContacts, dt_sec);
+	lastStepStats.frameBytes = frameArena.GetUsed();
+	frameArena.Reset();
 
 
 	if (IsShootFinished()) {
@@ -142,13 +129,298 @@ void Scene::Update(const float dt_sec)
 	}
 }
 
+// A body rests while both its speeds stay under these
+static const float SLEEP_LINEAR_SPEED = 0.05f;
+static const float SLEEP_ANGULAR_SPEED = 0.1f;
+// How long it must rest before it may sleep
+static const float TIME_TO_SLEEP = 0.5f;
+
+static float UpdateSleepTime(Body& body, const float dt_sec)
+{
+	if (body.linearVelocity.GetLengthSqr() > SLEEP_LINEAR_SPEED * SLEEP_LINEAR_SPEED
+	|| body.angularVelocity.GetLengthSqr() > SLEEP_ANGULAR_SPEED * SLEEP_ANGULAR_SPEED) {
+		body.sleepTime = 0.0f;
+	}
+	else {
+		body.sleepTime += dt_sec;
+	}
+	return body.sleepTime;
+}
+
+// Below this the islands are stepped on the calling thread, the
+// workers would take longer to wake up than the whole solve
+static const int MIN_CONTACTS_FOR_THREADS = 256;
+// From this many contacts an island is solved color by color
+static const int MIN_CONTACTS_FOR_COLORING = 128;
+
+void Scene::StepIslands(Contact* contacts, const int* contactPairs, const int numContacts, const float dt_sec)
+{
+	// Bodies joined by contacts form an island, the contacts of an island
+	// only move its own bodies so each island is stepped on its own.
+	// A contact with an awake body wakes a sleeping one, along with the
+	// rest of its island since every body of an island has a contact
+	for (int i = 0; i < numContacts; i++) {
+		const CollisionPair& pair = collisionPairs[contactPairs[i]];
+		Body* pairBodies[2] = { bodies[pair.a], bodies[pair.b] };
+		for (Body* body : pairBodies) {
+			if (body->inverseMass != 0.0f && !body->IsAwake()) {
+				body->SetAwake(true);
+			}
+		}
+	}
+
+	if (islandStepping) {
+		islands.Build(bodies, collisionPairs, contactPairs, numContacts);
+	}
+	else {
+		// Each contact advances the whole scene
+		islands.BuildSingle(bodies, numContacts);
+	}
+	const int numIslands = islands.GetNumIslands();
+	lastStepStats.numIslands = numIslands;
+
+	// Gather the contacts of each island next to each other
+	Contact* islandContacts = frameArena.Allocate<Contact>(numContacts);
+	ContactPoint** islandPoints = frameArena.Allocate<ContactPoint*>(numContacts);
+	for (int island = 0; island < numIslands; island++) {
+		const Island& desc = islands.GetIsland(island);
+		const int* contactIndices = islands.GetContacts(desc);
+		for (int j = 0; j < desc.numContacts; j++) {
+			const int slot = desc.firstContact + j;
+			islandContacts[slot] = contacts[contactIndices[j]];
+			if (contactSolverType == ContactSolverType::SEQUENTIAL_IMPULSE) {
+				// Merge into the persistent manifolds here, the map is not safe to grow from the islands
+				islandPoints[slot] = &contactCache.AddContact(bodies, bodyStorage, collisionPairs[contactPairs[contactIndices[j]]], islandContacts[slot]);
+			}
+		}
+	}
+	ContactConstraint* constraints = nullptr;
+	if (contactSolverType == ContactSolverType::SEQUENTIAL_IMPULSE) {
+		constraints = frameArena.Allocate<ContactConstraint>(numContacts);
+	}
+
+	// A large island is solved on its own with its contacts colored and spread
+	// over the threads, islands are handed out whole to the threads otherwise
+	int* islandBodyUpdates = frameArena.Allocate<int>(numIslands);
+	int* smallIslands = frameArena.Allocate<int>(numIslands);
+	int numSmallIslands = 0;
+	lastStepStats.numColors = 0;
+	for (const int island : islands.GetScheduleOrder()) {
+		const Island& desc = islands.GetIsland(island);
+		if (contactSolverType == ContactSolverType::SEQUENTIAL_IMPULSE && desc.numContacts >= MIN_CONTACTS_FOR_COLORING) {
+			islandBodyUpdates[island] = StepColoredIsland(desc, contactPairs, islandContacts, islandPoints, constraints, dt_sec);
+		}
+		else {
+			smallIslands[numSmallIslands++] = island;
+		}
+	}
+
+	// Islands share no dynamic body, they may run on any thread in any order
+	const auto stepIsland = [&](const int task) {
+		const int island = smallIslands[task];
+		islandBodyUpdates[island] = StepIsland(islands.GetIsland(island), islandContacts, islandPoints, constraints, dt_sec);
+	};
+	if (numContacts >= MIN_CONTACTS_FOR_THREADS && numSmallIslands > 1) {
+		JobSystem::Get().ParallelFor(numSmallIslands, stepIsland);
+	}
+	else {
+		for (int task = 0; task < numSmallIslands; task++) {
+			stepIsland(task);
+		}
+	}
+
+	int numBodyUpdates = 0;
+	for (int island = 0; island < numIslands; island++) {
+		numBodyUpdates += islandBodyUpdates[island];
+	}
+	// Bodies outside of any island (free or static) integrate once, unless asleep
+	for (int i = 0; i < (int)bodies.size(); ++i) {
+		Body& body = *bodies[i];
+		if (islands.GetBodyIsland(i) >= 0 || !body.IsAwake()) {
+			continue;
+		}
+		body.Update(dt_sec);
+		++numBodyUpdates;
+		if (sleepingEnabled && body.inverseMass != 0.0f && UpdateSleepTime(body, dt_sec) >= TIME_TO_SLEEP) {
+			body.SetAwake(false);
+		}
+	}
+	lastStepStats.numBodyUpdates = numBodyUpdates;
+
+	contactCache.EndStep();
+	lastStepStats.numCachedContacts = contactCache.GetNumMatched();
+}
+
+int Scene::StepColoredIsland(const Island& island, const int* contactPairs, Contact* islandContacts, ContactPoint** islandPoints, ContactConstraint* constraints, const float dt_sec)
+{
+	// The cache turned the contacts so that A is the lower body index
+	const int* contactIndices = islands.GetContacts(island);
+	CollisionPair* bodyPairs = frameArena.Allocate<CollisionPair>(island.numContacts);
+	for (int i = 0; i < island.numContacts; i++) {
+		const CollisionPair& pair = collisionPairs[contactPairs[contactIndices[i]]];
+		bodyPairs[i].a = std::min(pair.a, pair.b);
+		bodyPairs[i].b = std::max(pair.a, pair.b);
+	}
+	const int numColors = contactSolver.SolveColored(islandContacts + island.firstContact, islandPoints + island.firstContact, bodyPairs, island.numContacts, (int)bodies.size(), dt_sec, constraints + island.firstContact, frameArena);
+	lastStepStats.numColors = std::max(lastStepStats.numColors, numColors);
+
+	const int* bodyIndices = islands.GetBodies(island);
+	for (int j = 0; j < island.numBodies; ++j) {
+		bodies[bodyIndices[j]]->Update(dt_sec);
+	}
+	UpdateIslandSleep(island, dt_sec);
+	return island.numBodies;
+}
+
+int Scene::StepIsland(const Island& island, Contact* islandContacts, ContactPoint** islandPoints, ContactConstraint* constraints, const float dt_sec)
+{
+	Contact* firstContact = islandContacts + island.firstContact;
+	const int* bodyIndices = islands.GetBodies(island);
+	int numBodyUpdates = 0;
+
+	if (contactSolverType == ContactSolverType::SEQUENTIAL_IMPULSE) {
+		// All the contacts at once at the start of the step, then one integration
+		contactSolver.Solve(firstContact, islandPoints + island.firstContact, island.numContacts, dt_sec, constraints + island.firstContact);
+		for (int j = 0; j < island.numBodies; ++j) {
+			bodies[bodyIndices[j]]->Update(dt_sec);
+		}
+		numBodyUpdates += island.numBodies;
+	}
+	else {
+		// Sort times of impact
+		if (island.numContacts > 1) {
+			qsort(firstContact, island.numContacts, sizeof(Contact),
+			Contact::CompareContact);
+		}
+		// Contact resolve in order
+		float accumulatedTime = 0.0f;
+		for (int i = 0; i < island.numContacts; ++i)
+		{
+			Contact& contact = firstContact[i];
+			const float dt = contact.timeOfImpact - accumulatedTime;
+			// Position update
+			for (int j = 0; j < island.numBodies; ++j) {
+				bodies[bodyIndices[j]]->Update(dt);
+			}
+			numBodyUpdates += island.numBodies;
+			Contact::ResolveContact(contact);
+			accumulatedTime += dt;
+		}
+		// Update the positions for the rest of this frame's time.
+		const float timeRemaining = dt_sec - accumulatedTime;
+		if (timeRemaining > 0.0f)
+		{
+			for (int j = 0; j < island.numBodies; ++j) {
+				bodies[bodyIndices[j]]->Update(timeRemaining);
+			}
+			numBodyUpdates += island.numBodies;
+		}
+	}
+
+	UpdateIslandSleep(island, dt_sec);
+	return numBodyUpdates;
+}
+
+void Scene::UpdateIslandSleep(const Island& island, const float dt_sec)
+{
+	if (!sleepingEnabled) {
+		return;
+	}
+	// An island sleeps as a whole, one body still moving keeps the others awake
+	const int* bodyIndices = islands.GetBodies(island);
+	float minSleepTime = TIME_TO_SLEEP;
+	for (int j = 0; j < island.numBodies; ++j) {
+		minSleepTime = std::min(minSleepTime, UpdateSleepTime(*bodies[bodyIndices[j]], dt_sec));
+	}
+	if (minSleepTime >= TIME_TO_SLEEP) {
+		for (int j = 0; j < island.numBodies; ++j) {
+			bodies[bodyIndices[j]]->SetAwake(false);
+		}
+	}
+}
+
+Body* Scene::CreateBody()
+{
+	return bodyPool.Acquire();
+}
+
+Ball* Scene::CreateBall(const Type type, Player* player)
+{
+	return ballPool.Acquire(type, player);
+}
+
+ShapeSphere* Scene::CreateSphere(const float radius)
+{
+	return shapes.AcquireSphere(radius);
+}
+
+void Scene::ReleaseBody(Body* body)
+{
+	if (body->shape != nullptr) {
+		shapes.Release(body->shape);
+	}
+	if (ballPool.Owns(body)) {
+		ballPool.Release(static_cast<Ball*>(body));
+	}
+	else {
+		bodyPool.Release(body);
+	}
+}
+
+BodyHandle Scene::AddBody(Body* body)
+{
+	bodies.push_back(body);
+	return bodyStorage.Add();
+}
+
+bool Scene::RemoveBody(const BodyHandle handle)
+{
+	const int index = bodyStorage.GetIndex(handle);
+	if (index < 0) {
+		return false;
+	}
+	Body* body = bodies[index];
+	// Gravity pulls toward the earth every step, it stays
+	if (body == earth) {
+		return false;
+	}
+	// Forget the balls of the game that point at it. Removing the ball in
+	// flight ends the throw, the player may throw again.
+	if (body == cochonnet) {
+		cochonnet = nullptr;
+	}
+	if (body == currentBall) {
+		currentBall = nullptr;
+		canShoot = true;
+	}
+	balls.erase(std::remove(balls.begin(), balls.end(), body), balls.end());
+
+	contactCache.RemoveBody(handle);
+	bodies[index] = bodies.back();
+	bodies.pop_back();
+	bodyStorage.Remove(handle);
+
+	ReleaseBody(body);
+	return true;
+}
+
+void Scene::SetSleepingEnabled(const bool enable)
+{
+	sleepingEnabled = enable;
+	if (!enable) {
+		for (Body* body : bodies) {
+			body->SetAwake(true);
+		}
+	}
+}
+
 bool Scene::EndUpdate()
 {
 	if (!std::empty(nextSpawnBodies))
 	{
 		for (auto& body : nextSpawnBodies)
 		{
-			bodies.push_back(body);
+			AddBody(body);
 		}
 		nextSpawnBodies.clear(); // Clear the original list after moving
 		return true;
@@ -181,12 +453,12 @@ void Scene::SpawnBall(const Vec3& cameraPos, const Vec3& cameraFocusPoint, float
 	}
 
 	start = std::chrono::system_clock::now();
-	currentBall = new Ball(type, currentPlayer);
+	currentBall = CreateBall(type, currentPlayer);
 	currentBall->position = cameraPos + dir * 20;
 	dir.z += 0.1f;
 	currentBall->linearVelocity = dir * 35 * std::min(std::max(0.8f,strength) , 1.5f);
 	currentBall->orientation = Quat(0,0,0,1);
-	currentBall->shape = new ShapeSphere(radius);
+	currentBall->SetShape(CreateSphere(radius));
 	currentBall->inverseMass = 3.0f;
 	currentBall->elasticity = 0.1f;
 	currentBall->friction = 0.5f;
@@ -2,12 +2,36 @@
 //  Scene.h
 //
 #pragma once
-#include "application.h"
 #include <vector>
 #include <chrono>
 #include <string>
 
 #include "Ball.h"
+#include "BodyStorage.h"
+#include "Broadphase.h"
+#include "ContactSolver.h"
+#include "FrameArena.h"
+#include "ObjectPool.h"
+#include "ShapeRegistry.h"
+#include "SimulationIslands.h"
+
+/*
+====================================================
+SceneStepStats
+Counters from the last call to Scene::Update
+====================================================
+*/
+struct SceneStepStats {
+	int numBodies = 0;
+	int numAwakeBodies = 0;		// dynamic bodies that were not sleeping
+	int numPairs = 0;
+	int numContacts = 0;
+	int numIslands = 0;
+	int numBodyUpdates = 0;		// calls to Body::Update made to integrate the step
+	int numCachedContacts = 0;	// contacts warm started from the contact cache
+	int numColors = 0;		// most colors of a large island solved color by color
+	size_t frameBytes = 0;		// transient memory the step took from the frame arena
+};
 
 /*
 ====================================================
@@ -16,7 +40,7 @@ Scene
 */
 class Scene {
 public:
-	Scene() { bodies.reserve( 128 ); nextSpawnBodies.reserve(128);}
+	Scene() : frameArena( 256 * 1024 ) { bodies.reserve( 128 ); nextSpawnBodies.reserve(128); SetBroadPhaseType(BroadPhaseType::SWEEP_AND_PRUNE); }
 	~Scene();
 
 	void Reset();
@@ -24,10 +48,56 @@ public:
 	void Update( const float dt_sec );
 	bool EndUpdate();
 	
+	void SetBroadPhaseType(const BroadPhaseType type);
+	BroadPhaseType GetBroadPhaseType() const { return broadphase->GetType(); }
+
+	// Per-step scratch, its high-water mark tells how much to reserve up front
+	const FrameArena& GetFrameArena() const { return frameArena; }
+	void ReserveFrameMemory(const size_t bytes) { frameArena.Reserve(bytes); }
+
+	void SetContactSolverType(const ContactSolverType type) { contactSolverType = type; }
+	ContactSolverType GetContactSolverType() const { return contactSolverType; }
+	ContactSolver& GetContactSolver() { return contactSolver; }
+	const ContactCache& GetContactCache() const { return contactCache; }
+
+	// Bodies at rest for a while stop being simulated until something touches them
+	void SetSleepingEnabled(const bool enable);
+	bool GetSleepingEnabled() const { return sleepingEnabled; }
+
+	// Islands of the last step, rebuilt by every Update
+	const SimulationIslands& GetIslands() const { return islands; }
+
+	// Off, every contact's time of impact sub-step advances the whole scene
+	void SetIslandStepping(const bool enable) { islandStepping = enable; }
+	bool GetIslandStepping() const { return islandStepping; }
+
+	// Bodies come from the scene's pools, never delete them. Reset and
+	// RemoveBody give them back. Shapes are shared through the registry,
+	// each CreateSphere takes a reference the body gives back with it.
+	Body* CreateBody();
+	Ball* CreateBall(const Type type, class Player* player);
+	ShapeSphere* CreateSphere(const float radius);
+	int GetNumLiveBodies() const { return bodyPool.GetNumLive() + ballPool.GetNumLive(); }
+	const ShapeRegistry& GetShapes() const { return shapes; }
+	// Blocks held by the pools, live or free
+	int GetPoolCapacity() const { return bodyPool.GetCapacity() + ballPool.GetCapacity() + shapes.GetPoolCapacity(); }
+
+	// Bodies enter the scene through AddBody so that the storage keeps the
+	// order of bodies. Removing a body moves the last one into its index and
+	// forgets the cached contacts, the body and its shape go back to the pools.
+	// The game lets go of a removed ball, the earth cannot be removed.
+	BodyHandle AddBody(Body* body);
+	bool RemoveBody(const BodyHandle handle);
+	// Resolves the handles of AddBody to indices in bodies
+	const BodyStorage& GetBodyStorage() const { return bodyStorage; }
+
 	void SpawnBall(const Vec3& cameraPos, const Vec3& cameraFocusPoint, float strength);
 
-	std::vector<Body*> bodies;
+	// Changed through AddBody and RemoveBody only, so that the indices of the handles hold
+	const std::vector<Body*>& GetBodies() const { return bodies; }
+
 	std::vector<Body*> nextSpawnBodies;
+	SceneStepStats lastStepStats;
 	bool IsShootFinished();
 	void CheckClosestPlayer();
 	void PrintWhosTurn();
@@ -44,6 +114,31 @@ public:
 
 
 private:
+	void StepIslands(class Contact* contacts, const int* contactPairs, const int numContacts, const float dt_sec);
+	// Solves and integrates one island and puts it to sleep once it rests, returns the body updates
+	int StepIsland(const Island& island, class Contact* islandContacts, ContactPoint** islandPoints, ContactConstraint* constraints, const float dt_sec);
+	// Same with the contacts colored and spread over the threads, run from the thread stepping the scene
+	int StepColoredIsland(const Island& island, const int* contactPairs, class Contact* islandContacts, ContactPoint** islandPoints, ContactConstraint* constraints, const float dt_sec);
+	void UpdateIslandSleep(const Island& island, const float dt_sec);
+
+	void ReleaseBody(Body* body);
+
+	std::vector<Body*> bodies;
+
+	ObjectPool<Body> bodyPool;
+	ObjectPool<Ball> ballPool;
+	ShapeRegistry shapes;
+	BodyStorage bodyStorage;
+	BroadPhaseBackend* broadphase = nullptr;
+	std::vector<CollisionPair> collisionPairs;
+	FrameArena frameArena;
+	bool islandStepping = true;
+	bool sleepingEnabled = true;
+	ContactSolver contactSolver;
+	ContactCache contactCache;
+	SimulationIslands islands;
+	ContactSolverType contactSolverType = ContactSolverType::SEQUENTIAL_IMPULSE;
+
 	class Body* earth = nullptr;
 
 	class Player* player1 = nullptr;
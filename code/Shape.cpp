@@ -1,6 +1,12 @@
 ﻿#include "Shape.h"
 #include "Math/Matrix.h"
 
+void Shape::UpdateMassProperties()
+{
+	inertiaTensor = InertiaTensor();
+	inverseInertiaTensor = InverseInertiaTensor();
+}
+
 Mat3 ShapeSphere::InertiaTensor() const
 {
 	Mat3 tensor;
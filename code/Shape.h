@@ -14,12 +14,24 @@ public:
 	virtual ShapeType GetType() const = 0;
 	virtual Vec3 GetCenterOfMass() const { return centerOfMass; }
 	virtual Mat3 InertiaTensor() const = 0;
+	// Inertia tensors are symmetric, shapes with a diagonal one may do better
+	virtual Mat3 InverseInertiaTensor() const { return InertiaTensor().InverseSymmetric(); }
 
 	virtual Bounds GetBounds(const Vec3& pos, const Quat& orient) const = 0;
 	virtual Bounds GetBounds() const = 0;
+
+	// InertiaTensor and its inverse, per unit mass, computed once by the
+	// shape so that bodies sharing it do not invert the tensor again
+	const Mat3& GetInertiaTensor() const { return inertiaTensor; }
+	const Mat3& GetInverseInertiaTensor() const { return inverseInertiaTensor; }
 	
 protected:
+	// Called by the constructor of the final shape, once its parameters are set
+	void UpdateMassProperties();
+
 	Vec3 centerOfMass;
+	Mat3 inertiaTensor;
+	Mat3 inverseInertiaTensor;
 };
 
 
@@ -28,14 +40,17 @@ public:
 	ShapeSphere(float radiusP) : radius(radiusP)
 	{
 		centerOfMass.Zero();
+		UpdateMassProperties();
 	}
 	
 	ShapeType GetType() const override { return ShapeType::SHAPE_SPHERE; }
 	Mat3 InertiaTensor() const override;
+	Mat3 InverseInertiaTensor() const override { return InertiaTensor().InverseDiagonal(); }
 
 	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
 	Bounds GetBounds() const override;
 	
+	// Shared by every body of this size, see ShapeRegistry
 	float radius;
 };
 
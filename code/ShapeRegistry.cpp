@@ -0,0 +1,55 @@
+#include "ShapeRegistry.h"
+
+#include <string.h>
+
+uint64_t ShapeRegistry::SphereKey(const float radius)
+{
+	// The exact bits, shapes that differ at all are not merged
+	uint32_t bits;
+	memcpy(&bits, &radius, sizeof(bits));
+	return ((uint64_t)Shape::ShapeType::SHAPE_SPHERE << 32) | bits;
+}
+
+ShapeSphere* ShapeRegistry::AcquireSphere(const float radius)
+{
+	const uint64_t key = SphereKey(radius);
+	auto found = entries.find(key);
+	if (found == entries.end()) {
+		Entry entry;
+		entry.shape = spheres.Acquire(radius);
+		entry.refCount = 0;
+		found = entries.emplace(key, entry).first;
+		keys.emplace(entry.shape, key);
+	}
+	++found->second.refCount;
+	++numReferences;
+	return static_cast<ShapeSphere*>(found->second.shape);
+}
+
+void ShapeRegistry::Release(Shape* shape)
+{
+	const auto key = keys.find(shape);
+	if (key == keys.end()) {
+		return;
+	}
+	const auto found = entries.find(key->second);
+	--numReferences;
+	if (--found->second.refCount > 0) {
+		return;
+	}
+	switch (shape->GetType()) {
+	case Shape::ShapeType::SHAPE_SPHERE:
+		spheres.Release(static_cast<ShapeSphere*>(shape));
+		break;
+	}
+	entries.erase(found);
+	keys.erase(key);
+}
+
+void ShapeRegistry::Clear()
+{
+	entries.clear();
+	keys.clear();
+	spheres.ReleaseAll();
+	numReferences = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include "ObjectPool.h"
+#include "Shape.h"
+
+// One instance per shape type and parameters, shared by every body that
+// asks for the same shape. Each Acquire takes a reference that Release
+// gives back, the shape is freed with its last reference. Shared shapes
+// must not be modified, acquire another one instead.
+class ShapeRegistry
+{
+public:
+	ShapeSphere* AcquireSphere(const float radius);
+	void Release(Shape* shape);
+	// Frees every shape whatever its references
+	void Clear();
+
+	// Distinct shapes alive, and the references held on them
+	int GetNumShapes() const { return (int)entries.size(); }
+	int GetNumReferences() const { return numReferences; }
+	int GetPoolCapacity() const { return spheres.GetCapacity(); }
+
+private:
+	struct Entry
+	{
+		Shape* shape;
+		int refCount;
+	};
+
+	static uint64_t SphereKey(const float radius);
+
+	std::unordered_map<uint64_t, Entry> entries;
+	std::unordered_map<const Shape*, uint64_t> keys;
+	ObjectPool<ShapeSphere> spheres;
+	int numReferences = 0;
+};
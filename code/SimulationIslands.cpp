@@ -0,0 +1,114 @@
+#include "SimulationIslands.h"
+
+#include <algorithm>
+
+int SimulationIslands::FindRoot(int body)
+{
+	while (parent[body] != body) {
+		// Path halving keeps the trees flat
+		parent[body] = parent[parent[body]];
+		body = parent[body];
+	}
+	return body;
+}
+
+void SimulationIslands::Build(const std::vector<Body*>& bodies, const std::vector<CollisionPair>& pairs, const int* contactPairs, const int numContacts)
+{
+	const int numBodies = (int)bodies.size();
+	parent.resize(numBodies);
+	for (int i = 0; i < numBodies; i++) {
+		parent[i] = i;
+	}
+	for (int i = 0; i < numContacts; i++) {
+		const CollisionPair& pair = pairs[contactPairs[i]];
+		if (bodies[pair.a]->inverseMass != 0.0f && bodies[pair.b]->inverseMass != 0.0f) {
+			parent[FindRoot(pair.a)] = FindRoot(pair.b);
+		}
+	}
+
+	// Number the islands in the order of their first contact
+	rootIsland.assign(numBodies, -1);
+	int numIslands = 0;
+	contactIsland.resize(numContacts);
+	for (int i = 0; i < numContacts; i++) {
+		const CollisionPair& pair = pairs[contactPairs[i]];
+		const int dynamicBody = (bodies[pair.a]->inverseMass != 0.0f) ? pair.a : pair.b;
+		const int root = FindRoot(dynamicBody);
+		if (rootIsland[root] < 0) {
+			rootIsland[root] = numIslands++;
+		}
+		contactIsland[i] = rootIsland[root];
+	}
+	bodyIsland.resize(numBodies);
+	for (int i = 0; i < numBodies; i++) {
+		bodyIsland[i] = (bodies[i]->inverseMass != 0.0f) ? rootIsland[FindRoot(i)] : -1;
+	}
+
+	islands.resize(numIslands);
+	Bucket(numBodies, numContacts);
+}
+
+void SimulationIslands::BuildSingle(const std::vector<Body*>& bodies, const int numContacts)
+{
+	const int numBodies = (int)bodies.size();
+	const int island = (numContacts > 0) ? 0 : -1;
+	bodyIsland.resize(numBodies);
+	for (int i = 0; i < numBodies; i++) {
+		bodyIsland[i] = (bodies[i]->inverseMass != 0.0f && bodies[i]->IsAwake()) ? island : -1;
+	}
+	contactIsland.assign(numContacts, 0);
+
+	islands.resize(island + 1);
+	Bucket(numBodies, numContacts);
+}
+
+void SimulationIslands::Bucket(const int numBodies, const int numContacts)
+{
+	const int numIslands = (int)islands.size();
+	for (Island& island : islands) {
+		island.numBodies = 0;
+		island.numContacts = 0;
+	}
+	for (int i = 0; i < numContacts; i++) {
+		++islands[contactIsland[i]].numContacts;
+	}
+	for (int i = 0; i < numBodies; i++) {
+		if (bodyIsland[i] >= 0) {
+			++islands[bodyIsland[i]].numBodies;
+		}
+	}
+	int firstBody = 0;
+	int firstContact = 0;
+	for (Island& island : islands) {
+		island.firstBody = firstBody;
+		island.firstContact = firstContact;
+		firstBody += island.numBodies;
+		firstContact += island.numContacts;
+		// Counted again as they are filled in
+		island.numBodies = 0;
+		island.numContacts = 0;
+	}
+
+	bodyIndices.resize(firstBody);
+	contactIndices.resize(numContacts);
+	for (int i = 0; i < numContacts; i++) {
+		Island& island = islands[contactIsland[i]];
+		contactIndices[island.firstContact + island.numContacts++] = i;
+	}
+	for (int i = 0; i < numBodies; i++) {
+		if (bodyIsland[i] >= 0) {
+			Island& island = islands[bodyIsland[i]];
+			bodyIndices[island.firstBody + island.numBodies++] = i;
+		}
+	}
+
+	scheduleOrder.resize(numIslands);
+	for (int i = 0; i < numIslands; i++) {
+		scheduleOrder[i] = i;
+	}
+	std::sort(scheduleOrder.begin(), scheduleOrder.end(), [this](const int a, const int b) {
+		const int workA = islands[a].numContacts + islands[a].numBodies;
+		const int workB = islands[b].numContacts + islands[b].numBodies;
+		return (workA != workB) ? (workA > workB) : (a < b);
+	});
+}
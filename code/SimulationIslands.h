@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include "Broadphase.h"
+
+// Bodies joined by contacts, directly or through other bodies. Nothing
+// outside an island can push its bodies during the step, so each island
+// is solved, put to sleep and handed to a thread on its own.
+struct Island
+{
+	int firstBody;
+	int numBodies;
+	int firstContact;
+	int numContacts;
+};
+
+// The islands of a step, built with union-find over the body indices.
+// Static bodies (infinite mass) never join an island since a contact does
+// not move them, a ground contact belongs to the island of its dynamic body.
+// Bodies without any contact are in no island.
+// Rebuilt every step, the storage is kept to avoid allocating again.
+class SimulationIslands
+{
+public:
+	// contactPairs gives the pair in pairs behind each of the contacts
+	void Build(const std::vector<Body*>& bodies, const std::vector<CollisionPair>& pairs, const int* contactPairs, const int numContacts);
+	// A single island holding every contact and every awake dynamic body
+	void BuildSingle(const std::vector<Body*>& bodies, const int numContacts);
+
+	int GetNumIslands() const { return (int)islands.size(); }
+	const Island& GetIsland(const int island) const { return islands[island]; }
+
+	// Scene indices of the bodies of an island
+	const int* GetBodies(const Island& island) const { return bodyIndices.data() + island.firstBody; }
+	// Indices of the contacts of an island in the contacts of the step,
+	// only meaningful while the step that built the islands runs
+	const int* GetContacts(const Island& island) const { return contactIndices.data() + island.firstContact; }
+
+	// Island of a body, -1 when it is static or has no contact
+	int GetBodyIsland(const int body) const { return bodyIsland[body]; }
+
+	// Islands from the most work to the least, the order to hand them to
+	// threads so that a big island does not start last
+	const std::vector<int>& GetScheduleOrder() const { return scheduleOrder; }
+
+private:
+	int FindRoot(int body);
+	void Bucket(const int numBodies, const int numContacts);
+
+	std::vector<int> parent;
+	std::vector<int> rootIsland;
+	std::vector<int> bodyIsland;
+	std::vector<int> contactIsland;
+	std::vector<Island> islands;
+	std::vector<int> bodyIndices;
+	std::vector<int> contactIndices;
+	std::vector<int> scheduleOrder;
+};
@@ -0,0 +1,165 @@
+#include "SpatialHashGrid.h"
+
+#include <algorithm>
+#include <math.h>
+
+SpatialHashGrid::SpatialHashGrid() : fixedCellSize(0.0f), cellSize(1.0f), inverseCellSize(1.0f)
+{
+}
+
+uint64_t SpatialHashGrid::CellKey(const int x, const int y, const int z) const
+{
+	// 21 bits per axis, offset so negative cells pack too. CellCoord keeps
+	// the coordinates in range, so no two cells share a key
+	const uint64_t offset = 1 << 20;
+	const uint64_t mask = (1 << 21) - 1;
+	return (((uint64_t)(x + offset) & mask) << 42) | (((uint64_t)(y + offset) & mask) << 21) | ((uint64_t)(z + offset) & mask);
+}
+
+// Cell coordinates that fit the 21 bits of a key axis
+static const float MIN_CELL_COORD = -(float)(1 << 20);
+static const float MAX_CELL_COORD = (float)((1 << 20) - 1);
+
+int SpatialHashGrid::CellCoord(const float value) const
+{
+	// Clamped before the cast, a runaway body would overflow the int.
+	// Everything past the range shares the edge cells, the exact bounds
+	// test drops the pairs that only meet there. Written so NaN clamps too.
+	const float cell = floorf(value * inverseCellSize);
+	if (!(cell >= MIN_CELL_COORD)) {
+		return (int)MIN_CELL_COORD;
+	}
+	if (cell > MAX_CELL_COORD) {
+		return (int)MAX_CELL_COORD;
+	}
+	return (int)cell;
+}
+
+void SpatialHashGrid::ChooseCellSize()
+{
+	cellSize = fixedCellSize;
+	if (cellSize <= 0.0f) {
+		// Twice the median body keeps a typical body within 2x2x2 cells
+		std::vector<float> sorted = extents;
+		if (sorted.empty()) {
+			cellSize = 1.0f;
+		}
+		else {
+			std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+			cellSize = 2.0f * sorted[sorted.size() / 2];
+		}
+	}
+	cellSize = std::max(cellSize, 1e-3f);
+	inverseCellSize = 1.0f / cellSize;
+}
+
+void SpatialHashGrid::Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+{
+	finalPairs.clear();
+	const int numBodies = (int)bodies.size();
+
+	bounds.resize(numBodies);
+	extents.resize(numBodies);
+	for (int i = 0; i < numBodies; i++) {
+		bounds[i] = GetSweptBounds(*bodies[i], dt_sec);
+		extents[i] = std::max(bounds[i].WidthX(), std::max(bounds[i].WidthY(), bounds[i].WidthZ()));
+	}
+	ChooseCellSize();
+
+	// Bin every small body in the cells its bounds touch
+	largeBodies.clear();
+	entries.clear();
+	for (int i = 0; i < numBodies; i++) {
+		if (extents[i] > cellSize) {
+			largeBodies.push_back(i);
+			continue;
+		}
+		const int minX = CellCoord(bounds[i].mins.x);
+		const int minY = CellCoord(bounds[i].mins.y);
+		const int minZ = CellCoord(bounds[i].mins.z);
+		const int maxX = CellCoord(bounds[i].maxs.x);
+		const int maxY = CellCoord(bounds[i].maxs.y);
+		const int maxZ = CellCoord(bounds[i].maxs.z);
+		for (int z = minZ; z <= maxZ; z++) {
+			for (int y = minY; y <= maxY; y++) {
+				for (int x = minX; x <= maxX; x++) {
+					GridEntry entry;
+					entry.cell = CellKey(x, y, z);
+					entry.body = i;
+					entries.push_back(entry);
+				}
+			}
+		}
+	}
+
+	// Counting sort of the entries into a power of two hash table,
+	// so the bodies of a cell end up next to each other in memory
+	int numBuckets = 1;
+	while (numBuckets < (int)entries.size() * 2) {
+		numBuckets <<= 1;
+	}
+	const uint64_t bucketMask = (uint64_t)numBuckets - 1;
+	auto bucketOf = [bucketMask](const uint64_t cell) {
+		return (int)((cell * 0x9E3779B97F4A7C15ull) >> 32 & bucketMask);
+	};
+	bucketStarts.assign(numBuckets + 1, 0);
+	for (const GridEntry& entry : entries) {
+		bucketStarts[bucketOf(entry.cell) + 1]++;
+	}
+	for (int i = 0; i < numBuckets; i++) {
+		bucketStarts[i + 1] += bucketStarts[i];
+	}
+	sortedEntries.resize(entries.size());
+	for (const GridEntry& entry : entries) {
+		sortedEntries[bucketStarts[bucketOf(entry.cell)]++] = entry;
+	}
+	// The fill moved every start to the end of its bucket, shift them back
+	for (int i = numBuckets; i > 0; i--) {
+		bucketStarts[i] = bucketStarts[i - 1];
+	}
+	bucketStarts[0] = 0;
+
+	for (int bucket = 0; bucket < numBuckets; bucket++) {
+		const int first = bucketStarts[bucket];
+		const int last = bucketStarts[bucket + 1];
+		for (int i = first; i < last; i++) {
+			const GridEntry& a = sortedEntries[i];
+			for (int j = i + 1; j < last; j++) {
+				const GridEntry& b = sortedEntries[j];
+				// Different cells can share a bucket
+				if (a.cell != b.cell || !bounds[a.body].DoesIntersect(bounds[b.body])) {
+					continue;
+				}
+				// Two bodies can share several cells, only the cell holding
+				// the min corner of their overlap reports the pair
+				const Vec3 overlapMin(
+					std::max(bounds[a.body].mins.x, bounds[b.body].mins.x),
+					std::max(bounds[a.body].mins.y, bounds[b.body].mins.y),
+					std::max(bounds[a.body].mins.z, bounds[b.body].mins.z));
+				if (CellKey(CellCoord(overlapMin.x), CellCoord(overlapMin.y), CellCoord(overlapMin.z)) != a.cell) {
+					continue;
+				}
+				CollisionPair pair;
+				pair.a = std::min(a.body, b.body);
+				pair.b = std::max(a.body, b.body);
+				finalPairs.push_back(pair);
+			}
+		}
+	}
+
+	// Large bodies against everything, and against each other once
+	for (int i = 0; i < largeBodies.size(); i++) {
+		const int large = largeBodies[i];
+		for (int other = 0; other < numBodies; other++) {
+			if (other == large || (extents[other] > cellSize && other < large)) {
+				continue;
+			}
+			if (bounds[large].DoesIntersect(bounds[other])) {
+				CollisionPair pair;
+				pair.a = std::min(large, other);
+				pair.b = std::max(large, other);
+				finalPairs.push_back(pair);
+			}
+		}
+	}
+}
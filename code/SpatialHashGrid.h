@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "Broadphase.h"
+
+// Uniform grid hashed into a flat table, rebuilt every step in O(n).
+// The cells are sized from the typical body, anything much larger
+// (such as the ground sphere) is kept out of the grid in a list of
+// large bodies tested directly against every other body.
+class SpatialHashGrid : public BroadPhaseBackend
+{
+public:
+	SpatialHashGrid();
+
+	BroadPhaseType GetType() const override { return BroadPhaseType::HASH_GRID; }
+	void Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec) override;
+
+	// A cell size of zero picks it from the median body size every step
+	void SetCellSize(const float size) { fixedCellSize = size; }
+
+	float GetCellSize() const { return cellSize; }
+	int GetNumLargeBodies() const { return (int)largeBodies.size(); }
+	int GetNumEntries() const { return (int)entries.size(); }
+
+private:
+	struct GridEntry
+	{
+		uint64_t cell;
+		int body;
+	};
+
+	void ChooseCellSize();
+	uint64_t CellKey(const int x, const int y, const int z) const;
+	int CellCoord(const float value) const;
+
+	float fixedCellSize;
+	float cellSize;
+	float inverseCellSize;
+
+	std::vector<Bounds> bounds;
+	std::vector<float> extents;
+	std::vector<int> largeBodies;
+	std::vector<GridEntry> entries;
+	std::vector<GridEntry> sortedEntries;
+	std::vector<int> bucketStarts;
+};
@@ -0,0 +1,258 @@
+#include "SweepAndPrune.h"
+#include "Math/Bounds.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune() :
+axisMode(SapAxisMode::FIXED_DIAGONAL),
+axisInterval(30),
+updatesSinceAxisCheck(0)
+{
+	axis = Vec3(1, 1, 1);
+	axis.Normalize();
+}
+
+void SweepAndPrune::SetAxisMode(const SapAxisMode mode, const int interval)
+{
+	axisMode = mode;
+	axisInterval = interval > 0 ? interval : 1;
+	updatesSinceAxisCheck = axisInterval;
+	if (axisMode == SapAxisMode::FIXED_DIAGONAL) {
+		axis = Vec3(1, 1, 1);
+		axis.Normalize();
+		trackedBodies.clear();
+	}
+}
+
+void SweepAndPrune::Clear()
+{
+	trackedBodies.clear();
+	endpoints.clear();
+	bounds.Resize(0);
+	minValues.clear();
+	maxValues.clear();
+	pairs.clear();
+	pairIndices.clear();
+}
+
+uint64_t SweepAndPrune::PairKey(const int a, const int b)
+{
+	const uint32_t lo = (uint32_t)std::min(a, b);
+	const uint32_t hi = (uint32_t)std::max(a, b);
+	return ((uint64_t)hi << 32) | lo;
+}
+
+void SweepAndPrune::AddPair(const int a, const int b)
+{
+	const uint64_t key = PairKey(a, b);
+	if (pairIndices.find(key) != pairIndices.end()) {
+		return;
+	}
+	CollisionPair pair;
+	pair.a = a;
+	pair.b = b;
+	pairIndices[key] = (int)pairs.size();
+	pairs.push_back(pair);
+	++stats.numPairsAdded;
+}
+
+void SweepAndPrune::RemovePair(const int a, const int b)
+{
+	auto it = pairIndices.find(PairKey(a, b));
+	if (it == pairIndices.end()) {
+		return;
+	}
+	// Swap with the last pair so the removal stays O(1)
+	const int index = it->second;
+	pairIndices.erase(it);
+	const int last = (int)pairs.size() - 1;
+	if (index != last) {
+		pairs[index] = pairs[last];
+		pairIndices[PairKey(pairs[index].a, pairs[index].b)] = index;
+	}
+	pairs.pop_back();
+	++stats.numPairsRemoved;
+}
+
+void SweepAndPrune::RefreshEndpoints(const std::vector<Body*>& bodies, const float dt_sec)
+{
+	// A sleeping body has not moved since its endpoints were last set
+	const int numKnown = (int)minValues.size();
+	bounds.Resize((int)bodies.size());
+	minValues.resize(bodies.size());
+	maxValues.resize(bodies.size());
+	for (int i = 0; i < bodies.size(); i++) {
+		if (i < numKnown && !bodies[i]->IsAwake()) {
+			continue;
+		}
+		const Bounds swept = GetSweptBounds(*bodies[i], dt_sec);
+		bounds.Set(i, swept);
+		// Project the extent of the box on the axis, which
+		// need not point into the positive octant anymore
+		const Vec3 center = (swept.mins + swept.maxs) * 0.5f;
+		const Vec3 halfExtent = (swept.maxs - swept.mins) * 0.5f;
+		const float radius = fabsf(axis.x) * halfExtent.x + fabsf(axis.y) * halfExtent.y + fabsf(axis.z) * halfExtent.z;
+		minValues[i] = axis.Dot(center) - radius;
+		maxValues[i] = axis.Dot(center) + radius;
+	}
+	for (int i = 0; i < endpoints.size(); i++) {
+		PseudoBody& endpoint = endpoints[i];
+		endpoint.value = endpoint.ismin ? minValues[endpoint.id] : maxValues[endpoint.id];
+	}
+}
+
+void SweepAndPrune::AddBodies(const std::vector<Body*>& bodies, const int first)
+{
+	// New endpoints start at the end of the list, past everything, so they
+	// overlap nothing yet and the insertion sort adds their pairs as it goes
+	for (int i = first; i < bodies.size(); i++) {
+		trackedBodies.push_back(bodies[i]);
+		PseudoBody endpoint;
+		endpoint.id = i;
+		endpoint.ismin = true;
+		endpoint.value = 0.0f;
+		endpoints.push_back(endpoint);
+		endpoint.ismin = false;
+		endpoints.push_back(endpoint);
+	}
+}
+
+void SweepAndPrune::Rebuild(const std::vector<Body*>& bodies, const float dt_sec)
+{
+	Clear();
+	AddBodies(bodies, 0);
+	RefreshEndpoints(bodies, dt_sec);
+	// The endpoints come out of AddBodies in body order with each min before
+	// its max, the stable sort keeps that order between equal values
+	RadixSortEndpoints(endpoints.data(), (int)endpoints.size(), frameArena);
+
+	// Seed the pairs with a full sweep, same as BuildPairs
+	for (int i = 0; i < endpoints.size(); i++) {
+		const PseudoBody& a = endpoints[i];
+		if (!a.ismin) {
+			continue;
+		}
+		for (int j = i + 1; j < endpoints.size(); j++) {
+			const PseudoBody& b = endpoints[j];
+			if (b.id == a.id) {
+				break;
+			}
+			if (b.ismin) {
+				AddPair(a.id, b.id);
+			}
+		}
+	}
+}
+
+void SweepAndPrune::InsertionSort()
+{
+	for (int i = 1; i < endpoints.size(); i++) {
+		const PseudoBody key = endpoints[i];
+		int j = i - 1;
+		while (j >= 0 && key.value < endpoints[j].value) {
+			const PseudoBody& other = endpoints[j];
+			// A min moving before a max starts an overlap,
+			// a max moving before a min ends one
+			if (key.ismin && !other.ismin) {
+				AddPair(key.id, other.id);
+			}
+			else if (!key.ismin && other.ismin) {
+				RemovePair(key.id, other.id);
+			}
+			endpoints[j + 1] = other;
+			--j;
+			++stats.numSwaps;
+		}
+		endpoints[j + 1] = key;
+	}
+}
+
+bool SweepAndPrune::ChooseAxis(const std::vector<Body*>& bodies)
+{
+	// Static bodies such as the ground sit far from the play area
+	// and would dominate the spread, so only moving bodies count
+	Vec3 mean(0.0f);
+	int count = 0;
+	for (int i = 0; i < bodies.size(); i++) {
+		if (bodies[i]->inverseMass == 0.0f) {
+			continue;
+		}
+		mean += bodies[i]->position;
+		++count;
+	}
+	if (count < 2) {
+		return false;
+	}
+	mean *= 1.0f / (float)count;
+
+	Mat3 covariance;
+	covariance.Zero();
+	for (int i = 0; i < bodies.size(); i++) {
+		if (bodies[i]->inverseMass == 0.0f) {
+			continue;
+		}
+		const Vec3 d = bodies[i]->position - mean;
+		covariance.rows[0] += d * d.x;
+		covariance.rows[1] += d * d.y;
+		covariance.rows[2] += d * d.z;
+	}
+
+	// Power iteration for the eigenvector of the largest eigenvalue,
+	// started from the current axis since the spread changes slowly
+	Vec3 principal = axis + Vec3(0.1f, 0.2f, 0.3f);
+	for (int i = 0; i < 16; i++) {
+		principal = covariance * principal;
+		const float length = principal.GetMagnitude();
+		if (length < 1e-12f) {
+			return false;
+		}
+		principal *= 1.0f / length;
+	}
+
+	// Only swap axis when it turned more than ~10 degrees, a rebuild costs a full sort
+	const float minCosine = 0.985f;
+	if (fabsf(principal.Dot(axis)) >= minCosine) {
+		return false;
+	}
+	axis = principal;
+	return true;
+}
+
+void SweepAndPrune::Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec)
+{
+	stats = SweepAndPruneStats();
+
+	// Bodies are only ever appended to the scene, anything else
+	// (a reset, a removal) means the ids changed and we start over
+	bool isPrefix = trackedBodies.size() <= bodies.size();
+	for (int i = 0; isPrefix && i < trackedBodies.size(); i++) {
+		isPrefix = (trackedBodies[i] == bodies[i]);
+	}
+
+	bool axisChanged = false;
+	if (axisMode == SapAxisMode::PRINCIPAL_AXIS && ++updatesSinceAxisCheck >= axisInterval) {
+		updatesSinceAxisCheck = 0;
+		axisChanged = ChooseAxis(bodies);
+	}
+
+	if (!isPrefix || trackedBodies.empty() || axisChanged) {
+		Rebuild(bodies, dt_sec);
+		stats.rebuilt = true;
+	}
+	else {
+		AddBodies(bodies, (int)trackedBodies.size());
+		RefreshEndpoints(bodies, dt_sec);
+		InsertionSort();
+	}
+
+	// The pair set tracks overlaps on the sweep axis only,
+	// drop the pairs that are apart on another axis
+	finalPairs.resize(pairs.size());
+	const int numKept = bounds.FilterPairs(pairs.data(), (int)pairs.size(), finalPairs.data());
+	finalPairs.resize(numKept);
+
+	stats.axis = axis;
+	stats.numPairs = (int)pairs.size();
+	stats.numFalsePositives = (int)pairs.size() - numKept;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "Broadphase.h"
+#include "Math/BoundsSoA.h"
+
+enum class SapAxisMode
+{
+	FIXED_DIAGONAL,	// always sweep along (1,1,1)
+	PRINCIPAL_AXIS,	// sweep along the axis of largest spread of the body centers
+};
+
+struct SweepAndPruneStats
+{
+	Vec3 axis;
+	int numPairs = 0;		// pairs overlapping on the sweep axis
+	int numFalsePositives = 0;	// of those, pairs whose 3D bounds do not overlap and were dropped
+	int numSwaps = 0;
+	int numPairsAdded = 0;
+	int numPairsRemoved = 0;
+	bool rebuilt = false;
+};
+
+// Sweep and prune that keeps its sorted endpoints between steps.
+// Bodies barely move from one step to the next, so the endpoints are
+// re-sorted with an insertion sort and every swap of a min past a max
+// adds or removes a single pair, instead of rebuilding every pair.
+// Pairs are reported only when their boxes overlap on all three axes.
+class SweepAndPrune : public BroadPhaseBackend
+{
+public:
+	SweepAndPrune();
+
+	BroadPhaseType GetType() const override { return BroadPhaseType::SWEEP_AND_PRUNE; }
+	void Update(const std::vector<Body*>& bodies, std::vector<CollisionPair>& finalPairs, const float dt_sec) override;
+	void Clear();
+
+	// The principal axis is re-evaluated every interval updates, and the
+	// endpoints are only rebuilt when it turned far enough from the current one
+	void SetAxisMode(const SapAxisMode mode, const int interval = 30);
+
+	const Vec3& GetAxis() const { return axis; }
+	const SweepAndPruneStats& GetStats() const { return stats; }
+
+private:
+	void Rebuild(const std::vector<Body*>& bodies, const float dt_sec);
+	void AddBodies(const std::vector<Body*>& bodies, const int first);
+	void RefreshEndpoints(const std::vector<Body*>& bodies, const float dt_sec);
+	void InsertionSort();
+	void AddPair(const int a, const int b);
+	void RemovePair(const int a, const int b);
+	bool ChooseAxis(const std::vector<Body*>& bodies);
+
+	static uint64_t PairKey(const int a, const int b);
+
+	Vec3 axis;
+	SapAxisMode axisMode;
+	int axisInterval;
+	int updatesSinceAxisCheck;
+
+	std::vector<Body*> trackedBodies;
+	std::vector<PseudoBody> endpoints;
+	BoundsSoA bounds;
+	std::vector<float> minValues;
+	std::vector<float> maxValues;
+	std::vector<CollisionPair> pairs;
+	std::unordered_map<uint64_t, int> pairIndices;
+
+	SweepAndPruneStats stats;
+};
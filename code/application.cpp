@@ -19,6 +19,7 @@
 Application * application = NULL;
 
 #include <time.h>
+#include <unordered_map>
 #include <windows.h>
 
 static bool gIsInitialized( false );
@@ -76,14 +77,7 @@ void Application::Initialize() {
 	scene->Initialize();
 	scene->Reset();
 
-	m_models.reserve( scene->bodies.size() );
-	for ( int i = 0; i < scene->bodies.size(); i++ ) {
-		Model * model = new Model();
-		model->BuildFromShape( scene->bodies[ i ]->shape );
-		model->MakeVBO( &deviceContext );
-
-		m_models.push_back( model );
-	}
+	BuildModels();
 
 	m_mousePosition = Vec2( 0, 0 );
 	m_cameraPositionTheta = acosf( -1.0f ) / 2.0f;
@@ -291,10 +285,11 @@ void Application::Cleanup() {
 	scene = NULL;
 
 	// Delete models
-	for ( int i = 0; i < m_models.size(); i++ ) {
-		m_models[ i ]->Cleanup( deviceContext );
-		delete m_models[ i ];
+	for ( int i = 0; i < m_shapeModels.size(); i++ ) {
+		m_shapeModels[ i ]->Cleanup( deviceContext );
+		delete m_shapeModels[ i ];
 	}
+	m_shapeModels.clear();
 	m_models.clear();
 
 	// Delete Uniform Buffer Memory
@@ -311,6 +306,36 @@ void Application::Cleanup() {
 	glfwTerminate();
 }
 
+/*
+====================================================
+Application::BuildModels
+One model per distinct shape, bodies sharing a shape share its
+model. The frame before has been waited on, the old models can go.
+====================================================
+*/
+void Application::BuildModels() {
+	for ( int i = 0; i < m_shapeModels.size(); i++ ) {
+		m_shapeModels[ i ]->Cleanup( deviceContext );
+		delete m_shapeModels[ i ];
+	}
+	m_shapeModels.clear();
+	m_models.clear();
+
+	std::unordered_map< const Shape *, Model * > modelsByShape;
+	m_models.reserve( scene->GetBodies().size() );
+	for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+		const Shape * shape = scene->GetBodies()[ i ]->shape;
+		Model *& model = modelsByShape[ shape ];
+		if ( model == NULL ) {
+			model = new Model();
+			model->BuildFromShape( shape );
+			model->MakeVBO( &deviceContext );
+			m_shapeModels.push_back( model );
+		}
+		m_models.push_back( model );
+	}
+}
+
 /*
 ====================================================
 Application::OnWindowResized
@@ -504,9 +529,8 @@ void Application::MainLoop() {
 		// Run Update
 		if ( runPhysics ) {
 			int startTime = GetTimeMicroseconds();
-			for ( int i = 0; i < 2; i++ ) {
-				scene->Update( dt_sec * 0.5f );
-			}
+			// The impulse solver keeps the contacts stable in a single step per frame
+			scene->Update( dt_sec );
 			int endTime = GetTimeMicroseconds();
 
 			dt_us = (float)endTime - (float)startTime;
@@ -525,15 +549,7 @@ void Application::MainLoop() {
 
 		if(scene->EndUpdate())
 		{
-			m_models.clear();
-			m_models.reserve( scene->bodies.size() );
-			for ( int i = 0; i < scene->bodies.size(); i++ ) {
-				Model * model = new Model();
-				model->BuildFromShape( scene->bodies[ i ]->shape );
-				model->MakeVBO( &deviceContext );
-
-				m_models.push_back( model );
-			}
+			BuildModels();
 		}
 	}
 }
@@ -644,8 +660,8 @@ void Application::UpdateUniforms() {
 		//
 		//	Update the uniform buffer with the body positions/orientations
 		//
-		for ( int i = 0; i < scene->bodies.size(); i++ ) {
-			Body & body = *scene->bodies[ i ];
+		for ( int i = 0; i < scene->GetBodies().size(); i++ ) {
+			Body & body = *scene->GetBodies()[ i ];
 
 			Vec3 fwd = body.orientation.RotatePoint( Vec3( 1, 0, 0 ) );
 			Vec3 up = body.orientation.RotatePoint( Vec3( 0, 0, 1 ) );
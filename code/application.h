@@ -39,6 +39,7 @@ private:
 	void InitializeGLFW();
 	bool InitializeVulkan();
 	void Cleanup();
+	void BuildModels();
 	void UpdateUniforms();
 	void DrawFrame();
 	void ResizeWindow( int windowWidth, int windowHeight );
@@ -69,7 +70,8 @@ private:
 	//	Model
 	//
 	Model m_modelFullScreen;
-	std::vector< Model * > m_models;	// models for the bodies
+	std::vector< Model * > m_models;	// models for the bodies, shared by bodies of the same shape
+	std::vector< Model * > m_shapeModels;	// one per distinct shape, owns the models
 
 	//
 	//	Pipeline for copying the offscreen framebuffer to the swapchain